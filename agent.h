@@ -0,0 +1,51 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 07:21:06 AM
+ *
+ ***********************************************************************
+ */
+
+#ifndef AGENT_H_
+#define AGENT_H_
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "spawn.h"
+
+/*
+ * Builtin to list, add and remove agents
+ */
+#define AGENT_CMD				"agent"
+
+/*
+ * Maximum number of registered agents
+ */
+#define AGENT_MAX				32
+
+/*
+ * Length of [HOST:]PORT of an agent
+ */
+#define AGENT_ADDR_LEN		64
+
+/*
+ * How long to wait for an agent to accept a connection (ms)
+ */
+#define AGENT_CONNECT_MS		3000
+
+/*
+ * TCP keepalive of connections to agents: idle time, interval (s) and
+ * number of probes before an agent is considered dead
+ */
+#define AGENT_KEEPIDLE		5
+#define AGENT_KEEPINTVL		1
+#define AGENT_KEEPCNT		3
+
+int agent_command(char ** argv, const struct spawn_attr_t * attr);
+bool agent_registered();
+pid_t agent_spawn(char ** argv, const struct spawn_attr_t * attr);
+int agent_remote(const char * agents, char ** argv);
+
+#endif // AGENT_H_
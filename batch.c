@@ -0,0 +1,277 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 08:15:52 PM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "batch.h"
+
+/*
+ * Bytes left free below ARG_MAX, the same headroom POSIX requires of xargs
+ */
+#define BATCH_HEADROOM			2048
+
+/*
+ * Linux refuses any single argument longer than 32 pages
+ */
+#define BATCH_ARG_PAGES			32
+
+/*
+ * Initial size of the buffer for arguments read from input
+ */
+#define BATCH_READ_SIZE			65536
+
+static const char * ERR_BATCH_USAGE		= "usage: batch [-j jobs] command [options] args...\n"
+													  "       batch [-j jobs] command [options] < file\n";
+static const char * ERR_BATCH_ENV		= "batch: environment exceeds ARG_MAX\n";
+static const char * ERR_BATCH_ARG		= "batch: argument too long\n";
+static const char * ERR_BATCH_JOBS		= "batch: -j cannot be used with &, background batches all start at once\n";
+
+extern char ** environ;
+
+/**
+ * @brief  Space taken by an argument on the new process stack
+ *
+ * @param arg argument
+ *
+ * @return   size in bytes
+ */
+static inline
+size_t arg_size(const char * arg) {
+	return strlen(arg) + 1 + sizeof(char *);
+}
+
+/**
+ * @brief  Space available for argv, i.e. ARG_MAX without environment
+ *
+ * @return   size in bytes, 0 if there is no space left
+ */
+static
+size_t arg_space() {
+	long arg_max = sysconf(_SC_ARG_MAX);
+	size_t used = BATCH_HEADROOM + sizeof(char *);
+
+	if (arg_max <= 0)
+		arg_max = _POSIX_ARG_MAX;
+
+	for (char ** env = environ; env && *env; ++env)
+		used += arg_size(*env);
+
+	return (size_t) arg_max > used ? (size_t) arg_max - used : 0;
+}
+
+/**
+ * @brief  Read arguments from a descriptor, one per line
+ *
+ * A command line is limited to BUF_SIZE, so this is the way to pass
+ * argument lists which come anywhere near ARG_MAX. Empty lines are skipped.
+ *
+ * @param fd descriptor to read from
+ * @param argv fixed part of the command, copied to the new vector
+ * @param nfixed number of fixed arguments
+ * @param data where to store the buffer holding arguments, to be freed
+ *
+ * @return   new NULL terminated vector to be freed or NULL on failure
+ */
+static
+char ** batch_read_args(int fd, char ** argv, size_t nfixed, char ** data) {
+	size_t size = BATCH_READ_SIZE, len = 0, nlines = 0, n, i;
+	char ** args;
+	char * buf, * tmp, * line, * eol;
+	ssize_t ret;
+
+	if (! (buf = (char *) malloc(size)))
+		return NULL;
+
+	for (;;) {
+		if (len + 1 == size) {
+			if (! (tmp = (char *) realloc(buf, 2 * size))) {
+				free(buf);
+				return NULL;
+			}
+			buf = tmp;
+			size *= 2;
+		}
+
+		if ((ret = read(fd, buf + len, size - len - 1)) < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("batch");
+			free(buf);
+			return NULL;
+		}
+
+		if (ret == 0)
+			break;
+
+		for (i = len; i < len + ret; ++i)
+			nlines += buf[i] == '\n';
+		len += ret;
+	}
+	buf[len] = '\0';
+
+	if (! (args = (char **) malloc((nfixed + nlines + 2) * sizeof(char *)))) {
+		free(buf);
+		return NULL;
+	}
+
+	memcpy(args, argv, nfixed * sizeof(char *));
+	n = nfixed;
+	for (line = buf; *line; line = eol + 1) {
+		if (! (eol = strchr(line, '\n')))
+			eol = line + strlen(line) - 1; // last line without '\n'
+		else
+			*eol = '\0';
+		if (*line)
+			args[n++] = line;
+	}
+	args[n] = (char *) 0;
+
+	*data = buf;
+
+	return args;
+}
+
+/**
+ * @brief  Run command with trailing arguments split into batches fitting
+ *         into ARG_MAX
+ *
+ * Leading arguments starting with '-' (up to and including "--") are
+ * options of the command and they are repeated in every batch. Without
+ * trailing arguments and with redirected input, they are read from the
+ * input, one per line, and batches get /dev/null as input instead.
+ * Background batches are separate jobs all started at once, so -j is
+ * refused for them.
+ *
+ * @param argv NULL terminated vector, argv[0] is the "batch" prefix
+ * @param attr attributes of spawned batches
+ *
+ * @return   maximum exit status of all batches, -1 on error
+ */
+int batch_command(char ** argv, const struct spawn_attr_t * attr) {
+	struct spawn_attr_t child = *attr;
+	long jobs = 1;
+	size_t argc, nfixed, fixed_size, space, size, max_arg;
+	size_t first, last, n, i;
+	pid_t * pids, pid;
+	bool failed = false;
+	char ** cmd, ** args = NULL;
+	char * end, * data = NULL;
+	int status, ret = 0;
+
+	++argv; // skip prefix
+
+	if (argv[0] && ! strcmp(argv[0], "-j")) {
+		if (! argv[1] || (jobs = strtol(argv[1], &end, 10)) <= 0 || *end) {
+			write(2, ERR_BATCH_USAGE, strlen(ERR_BATCH_USAGE));
+			return -1;
+		}
+		if (attr->background) {
+			write(2, ERR_BATCH_JOBS, strlen(ERR_BATCH_JOBS));
+			return -1;
+		}
+		argv += 2;
+	}
+
+	if (! argv[0]) {
+		write(2, ERR_BATCH_USAGE, strlen(ERR_BATCH_USAGE));
+		return -1;
+	}
+
+	for (argc = 0; argv[argc]; ++argc)
+		;
+
+	fixed_size = arg_size(argv[0]);
+	for (nfixed = 1; nfixed < argc && argv[nfixed][0] == '-'; ) {
+		fixed_size += arg_size(argv[nfixed]);
+		if (! strcmp(argv[nfixed++], "--"))
+			break;
+	}
+
+	space = arg_space();
+	if (space <= fixed_size) {
+		write(2, ERR_BATCH_ENV, strlen(ERR_BATCH_ENV));
+		return -1;
+	}
+	space -= fixed_size;
+
+	if (nfixed == argc && attr->fd_in >= 0) {
+		if (! (args = batch_read_args(attr->fd_in, argv, nfixed, &data)))
+			return -1;
+		if ((child.fd_in = open("/dev/null", O_RDONLY | O_CLOEXEC)) < 0)
+			child.fd_in = SPAWN_FD_CLOSE;
+		for (argv = args; argv[argc]; ++argc)
+			;
+	}
+
+	max_arg = BATCH_ARG_PAGES * (size_t) sysconf(_SC_PAGESIZE);
+	for (n = nfixed; n < argc && ! failed; ++n) {
+		if (strlen(argv[n]) >= max_arg || arg_size(argv[n]) > space) {
+			write(2, ERR_BATCH_ARG, strlen(ERR_BATCH_ARG));
+			failed = true;
+		}
+	}
+
+	cmd = (char **) malloc((argc + 1) * sizeof(char *));
+	pids = (pid_t *) malloc(jobs * sizeof(pid_t));
+	if (failed || ! cmd || ! pids) {
+		failed = true;
+		goto out;
+	}
+
+	memcpy(cmd, argv, nfixed * sizeof(char *));
+
+	/*
+	 * Batches are reaped in FIFO order, at most jobs of them are in flight
+	 */
+	first = last = 0;
+	n = nfixed;
+	do {
+		for (size = 0, i = nfixed; n < argc
+				&& size + arg_size(argv[n]) <= space; ++n, ++i) {
+			size += arg_size(argv[n]);
+			cmd[i] = argv[n];
+		}
+		cmd[i] = (char *) 0;
+
+		if (last - first == (size_t) jobs) {
+			status = spawn_wait(pids[first++ % jobs]);
+			if (status > ret) ret = status;
+		}
+
+		if ((pid = spawn_command(cmd, &child)) < 0) {
+			failed = true;
+			break;
+		}
+
+		if (! attr->background)
+			pids[last++ % jobs] = pid;
+	} while (n < argc);
+
+	while (first != last) {
+		status = spawn_wait(pids[first++ % jobs]);
+		if (status > ret) ret = status;
+	}
+
+out:
+	if (child.fd_in >= 0 && child.fd_in != attr->fd_in)
+		close(child.fd_in);
+	free(cmd);
+	free(pids);
+	free(args);
+	free(data);
+
+	return failed ? -1 : ret;
+}
+
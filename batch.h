@@ -0,0 +1,23 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 08:15:40 PM
+ *
+ ***********************************************************************
+ */
+
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include "spawn.h"
+
+/*
+ * Builtin prefix for ARG_MAX aware batching
+ */
+#define BATCH_CMD				"batch"
+
+int batch_command(char ** argv, const struct spawn_attr_t * attr);
+
+#endif // BATCH_H_
+
@@ -0,0 +1,134 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 03:21:07 AM
+ *
+ ***********************************************************************
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+
+/*
+ * Every benchmark prints one row per case: the bench name, columns
+ * identifying the case (keys), iterations and latency in microseconds.
+ * Rows are CSV with a header by default, JSON objects one per line with -j.
+ * bench/compare matches CSV rows by bench name and keys.
+ */
+
+static bool bench_json = false;
+static const char * bench_keys = "";
+
+/**
+ * @brief  Current time in nanoseconds
+ *
+ * @return   monotonic time
+ */
+static inline
+long long now_ns() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief  Compare latencies for qsort()
+ */
+static inline
+int cmp_ll(const void * a, const void * b) {
+	long long x = *(const long long *) a;
+	long long y = *(const long long *) b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief  Parse common arguments: [-j] [iterations]
+ *
+ * @param argc argument count
+ * @param argv argument vector
+ * @param n default number of iterations
+ *
+ * @return   number of iterations
+ */
+static inline
+int bench_args(int argc, char * argv[], int n) {
+	int opt, val;
+
+	while ((opt = getopt(argc, argv, "j")) != -1) {
+		if (opt == 'j')
+			bench_json = true;
+	}
+
+	if (optind < argc && (val = atoi(argv[optind])) > 0)
+		n = val;
+
+	return n;
+}
+
+/**
+ * @brief  Print header, has to be called before bench_report()
+ *
+ * @param keys comma separated names of columns identifying a case
+ */
+static inline
+void bench_header(const char * keys) {
+	bench_keys = keys;
+	if (! bench_json)
+		printf("bench,%s,iterations,mean_us,p50_us,p99_us\n", keys);
+}
+
+/**
+ * @brief  Print result of one case, lat is sorted in place
+ *
+ * @param bench name of the benchmark
+ * @param values comma separated values of columns given to bench_header()
+ * @param lat latencies in nanoseconds
+ * @param n number of latencies
+ */
+static inline
+void bench_report(const char * bench, const char * values, long long * lat, int n) {
+	const char * k = bench_keys;
+	const char * v = values;
+	size_t klen, vlen;
+	long long sum = 0;
+	double mean, p50, p99;
+
+	for (int i = 0; i < n; ++i)
+		sum += lat[i];
+
+	qsort(lat, n, sizeof(long long), cmp_ll);
+	mean = sum / 1000.0 / n;
+	p50 = lat[n / 2] / 1000.0;
+	p99 = lat[n * 99 / 100] / 1000.0;
+
+	if (! bench_json) {
+		printf("%s,%s,%d,%.3f,%.3f,%.3f\n", bench, values, n, mean, p50, p99);
+		fflush(stdout);
+		return;
+	}
+
+	printf("{\"bench\":\"%s\"", bench);
+	while (*k && *v) {
+		klen = strcspn(k, ",");
+		vlen = strcspn(v, ",");
+		printf(",\"%.*s\":\"%.*s\"", (int) klen, k, (int) vlen, v);
+		k += klen + (k[klen] == ',');
+		v += vlen + (v[vlen] == ',');
+	}
+	printf(",\"iterations\":%d,\"mean_us\":%.3f,\"p50_us\":%.3f,\"p99_us\":%.3f}\n",
+			n, mean, p50, p99);
+	fflush(stdout);
+}
+
+#endif // BENCH_H_
+
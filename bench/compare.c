@@ -0,0 +1,218 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 03:52:40 AM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+/*
+ * Compare two CSV result files of the benchmarks, e.g. a saved baseline and
+ * the current run. Cases are matched by bench name and key columns, their
+ * medians are compared. Exits with 1 if any case got slower than the
+ * threshold (percent), with 2 if a file holds no CSV results (e.g. JSON
+ * printed using -j) or no case of the baseline was run.
+ */
+
+#define COMPARE_THRESHOLD			10.0
+
+/*
+ * Differences below this (us) are noise whatever the percentage is
+ */
+#define COMPARE_MIN_US				0.010
+
+#define COMPARE_LINE_LEN			1024
+
+static const char * COL_ITERATIONS	= "iterations";
+static const char * COL_P50			= "p50_us";
+
+static const char * ERR_NO_RESULTS	= "%s: no CSV results\n";
+static const char * ERR_NO_MATCH		= "no case matches the baseline\n";
+
+/**
+ * @brief  Result of one case
+ */
+struct result_t {
+	char * key;
+	double p50;
+	bool seen;
+	struct result_t * next;
+};
+
+/**
+ * @brief  Get index of a column in CSV header
+ *
+ * @param header header line
+ * @param name column name
+ *
+ * @return   column index or -1
+ */
+static
+int column(const char * header, const char * name) {
+	size_t len = strlen(name);
+	int i = 0;
+
+	for (const char * c = header; c; c = strchr(c, ','), c = c ? c + 1 : c, ++i)
+		if (! strncmp(c, name, len) && (c[len] == ',' || c[len] == '\0'))
+			return i;
+
+	return -1;
+}
+
+/**
+ * @brief  Read results from a CSV file
+ *
+ * @param path file to read
+ * @param results where to append results
+ *
+ * @return   true on success, false also if there is no result
+ */
+static
+bool read_results(const char * path, struct result_t ** results) {
+	char line[COMPARE_LINE_LEN];
+	int iterations = -1, p50 = -1;
+	size_t rows = 0;
+	struct result_t * res;
+	char * c;
+	int i;
+	FILE * f;
+
+	if (! (f = fopen(path, "r"))) {
+		perror(path);
+		return false;
+	}
+
+	while (*results)
+		results = &(*results)->next;
+
+	while (fgets(line, sizeof(line), f)) {
+		line[strcspn(line, "\n")] = '\0';
+
+		if (! strncmp(line, "bench,", 6)) { // header of the next bench
+			iterations = column(line, COL_ITERATIONS);
+			p50 = column(line, COL_P50);
+			continue;
+		}
+
+		if (iterations < 0 || p50 < 0)
+			continue;
+
+		// key is everything before iterations
+		for (i = 0, c = line; c && i < iterations; ++i)
+			if ((c = strchr(c, ',')))
+				++c;
+		if (! c)
+			continue;
+
+		res = (struct result_t *) malloc(sizeof(struct result_t));
+		if (! res)
+			break;
+
+		res->key = strndup(line, c - line - 1);
+		for (; i < p50 && c; ++i)
+			if ((c = strchr(c, ',')))
+				++c;
+		res->p50 = c ? atof(c) : 0;
+		res->seen = false;
+		res->next = NULL;
+		*results = res;
+		results = &res->next;
+		rows++;
+	}
+
+	fclose(f);
+
+	if (rows == 0) {
+		fprintf(stderr, ERR_NO_RESULTS, path);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Print usage
+ *
+ * @param pname program name
+ *
+ * @return   always 2
+ */
+static
+int print_help(const char * pname) {
+	fprintf(stderr, "Usage: %s BASELINE.csv CURRENT.csv [THRESHOLD_PCT]\n", pname);
+
+	return 2;
+}
+
+/**
+ * @brief  main
+ *
+ * @param argc argument count
+ * @param argv[] argument vector
+ *
+ * @return   0 if there is no regression, 1 if there is, 2 on error
+ */
+int main(int argc, char * argv[]) {
+	struct result_t * base = NULL;
+	struct result_t * cur = NULL;
+	struct result_t * b, * r;
+	double threshold = COMPARE_THRESHOLD;
+	double change;
+	int regressions = 0;
+	int matched = 0;
+
+	if (argc < 3 || argc > 4)
+		return print_help(argv[0]);
+
+	if (argc == 4)
+		threshold = atof(argv[3]);
+
+	if (! read_results(argv[1], &base) || ! read_results(argv[2], &cur))
+		return 2;
+
+	printf("case,baseline_p50_us,current_p50_us,change_pct,status\n");
+
+	for (r = cur; r; r = r->next) {
+		for (b = base; b && strcmp(b->key, r->key); b = b->next)
+			;
+
+		if (! b) {
+			printf("\"%s\",,%.3f,,new\n", r->key, r->p50);
+			continue;
+		}
+
+		b->seen = true;
+		matched++;
+		change = b->p50 > 0 ? (r->p50 - b->p50) * 100 / b->p50 : 0;
+
+		if (change > threshold && r->p50 - b->p50 > COMPARE_MIN_US) {
+			printf("\"%s\",%.3f,%.3f,%+.1f,REGRESSION\n", r->key, b->p50, r->p50, change);
+			regressions++;
+		} else {
+			printf("\"%s\",%.3f,%.3f,%+.1f,%s\n", r->key, b->p50, r->p50, change,
+					change < -threshold ? "faster" : "ok");
+		}
+	}
+
+	for (b = base; b; b = b->next)
+		if (! b->seen)
+			printf("\"%s\",%.3f,,,missing\n", b->key, b->p50);
+
+	if (! matched) {
+		fprintf(stderr, "%s", ERR_NO_MATCH);
+		return 2;
+	}
+
+	if (regressions)
+		fprintf(stderr, "%d case(s) slower than baseline by more than %g%%\n",
+				regressions, threshold);
+
+	return regressions ? 1 : 0;
+}
+
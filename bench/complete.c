@@ -0,0 +1,140 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 09:02:26 AM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "bench.h"
+
+/*
+ * index_add() is static, benchmark it in the same translation unit
+ */
+#include "../complete.c"
+
+/*
+ * Cost of Tab in a PATH directory with as many executables as big hosts
+ * have: indexing it (done once, in background), completing a command from
+ * the trie and completing a file name in it using getdents64.
+ */
+
+#define COMPLETE_FILES				30000
+
+/*
+ * Prefixes completed, from many matches to a single one
+ */
+static const char * PREFIXES[] = { "", "k", "kq", "kqx", "kqxa0" };
+
+/**
+ * @brief  Create directory with executables named by a fixed seed
+ *
+ * @param dir where to create them
+ * @param n number of executables
+ *
+ * @return   true on success
+ */
+static
+bool dir_fill(const char * dir, int n) {
+	char path[256];
+	int len, fd;
+
+	if (mkdir(dir, 0700) < 0)
+		return false;
+
+	srand(1);
+	for (int i = 0; i < n; ++i) {
+		len = snprintf(path, sizeof(path), "%s/", dir);
+		for (int c = 4 + rand() % 8; c > 0; --c)
+			path[len++] = 'a' + rand() % 26;
+		snprintf(path + len, sizeof(path) - len, "%d", i);
+
+		if ((fd = open(path, O_WRONLY | O_CREAT, 0755)) < 0)
+			return false;
+		close(fd);
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Remove the directory
+ *
+ * @param dir directory to remove
+ */
+static
+void dir_remove(const char * dir) {
+	char cmd[512];
+
+	snprintf(cmd, sizeof(cmd), "rm -rf '%s'", dir);
+	system(cmd);
+}
+
+/**
+ * @brief  main
+ *
+ * @param argc argument count
+ * @param argv[] argument vector: [-j] [iterations]
+ *
+ * @return   EXIT_SUCCESS on success, otherwise EXIT_FAILURE
+ */
+int main(int argc, char * argv[]) {
+	int n = bench_args(argc, argv, 1000);
+	static struct complete_t res;
+	char dir[64], word[256], values[64];
+	long long * lat;
+	long long start;
+	size_t p;
+
+	snprintf(dir, sizeof(dir), "/tmp/proj3-bench-%d", getpid());
+
+	lat = (long long *) malloc(n * sizeof(long long));
+	complete_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (! lat || complete_inotify < 0 || ! dir_fill(dir, COMPLETE_FILES)) {
+		fprintf(stderr, "%s: unable to create %s\n", argv[0], dir);
+		dir_remove(dir);
+		return EXIT_FAILURE;
+	}
+
+	bench_header("op,prefix");
+
+	start = now_ns();
+	index_add(dir);
+	lat[0] = now_ns() - start;
+	snprintf(values, sizeof(values), "index,%d", COMPLETE_FILES);
+	bench_report("complete", values, lat, 1);
+
+	for (p = 0; p < sizeof(PREFIXES) / sizeof(PREFIXES[0]); ++p) {
+		for (int i = 0; i < n; ++i) {
+			start = now_ns();
+			complete_command(PREFIXES[p], &res);
+			lat[i] = now_ns() - start;
+		}
+		snprintf(values, sizeof(values), "command,'%s'", PREFIXES[p]);
+		bench_report("complete", values, lat, n);
+	}
+
+	for (p = 0; p < sizeof(PREFIXES) / sizeof(PREFIXES[0]); ++p) {
+		snprintf(word, sizeof(word), "%s/%s", dir, PREFIXES[p]);
+		for (int i = 0; i < n / 10 + 1; ++i) {
+			start = now_ns();
+			complete_file(word, &res);
+			lat[i] = now_ns() - start;
+		}
+		snprintf(values, sizeof(values), "file,'%s'", PREFIXES[p]);
+		bench_report("complete", values, lat, n / 10 + 1);
+	}
+
+	dir_remove(dir);
+	free(lat);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,289 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 06:48:09 AM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "bench.h"
+#include "../daemon.h"
+
+/*
+ * Cost of a command run by a fresh shell per request (as services shelling
+ * out do) and by proj3 -d with 1 and more requests in flight. A sample is
+ * the time between two completed requests, i.e. mean is 1 / throughput.
+ */
+
+static const char * BENCH_SHELL		= "./proj3";
+static const char * BENCH_CMD			= "true";
+
+static const int DEPTHS[] = { 1, 16 };
+
+/*
+ * How long to wait for the daemon to listen (ms)
+ */
+#define DAEMON_START_MS				5000
+
+/**
+ * @brief  Read exactly len bytes
+ *
+ * @param fd descriptor to read from
+ * @param buf where to store data
+ * @param len length of data
+ *
+ * @return   true on success
+ */
+static
+bool read_all(int fd, void * buf, size_t len) {
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = read(fd, buf, len);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+		buf = (char *) buf + ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Run the command by a fresh shell reading it from stdin
+ *
+ * @return   true on success
+ */
+static
+bool run_shell() {
+	int in[2];
+	int null;
+	pid_t pid;
+
+	if (pipe2(in, O_CLOEXEC) < 0)
+		return false;
+
+	pid = fork();
+	if (pid == 0) {
+		null = open("/dev/null", O_WRONLY);
+		dup2(in[0], STDIN_FILENO);
+		dup2(null, STDOUT_FILENO);
+		dup2(null, STDERR_FILENO);
+		execl(BENCH_SHELL, BENCH_SHELL, (char *) NULL);
+		_exit(127);
+	}
+
+	close(in[0]);
+	write(in[1], BENCH_CMD, strlen(BENCH_CMD));
+	write(in[1], "\n", 1);
+	close(in[1]); // end of file exits the shell
+
+	return pid > 0 && waitpid(pid, NULL, 0) == pid;
+}
+
+/**
+ * @brief  Start the daemon and connect to it
+ *
+ * @param path path of the socket
+ * @param pid where to store PID of the daemon
+ *
+ * @return   connected socket or -1 on failure
+ */
+static
+int daemon_connect(const char * path, pid_t * pid) {
+	struct sockaddr_un addr;
+	int fd, null, i;
+
+	*pid = fork();
+	if (*pid == 0) {
+		null = open("/dev/null", O_WRONLY);
+		dup2(null, STDERR_FILENO);
+		execl(BENCH_SHELL, BENCH_SHELL, "-d", path, (char *) NULL);
+		_exit(127);
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+
+	for (i = 0; i < DAEMON_START_MS && *pid > 0; ++i) {
+		if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0)
+			return -1;
+		if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0)
+			return fd;
+		close(fd);
+		usleep(1000);
+	}
+
+	return -1;
+}
+
+/**
+ * @brief  Send a request to run the command
+ *
+ * @param fd connection to the daemon
+ * @param id id of the request
+ *
+ * @return   true on success
+ */
+static
+bool daemon_send(int fd, uint32_t id) {
+	char buf[sizeof(struct daemon_hdr_t) + 64];
+	struct daemon_hdr_t hdr;
+	size_t len;
+
+	// command line and empty working directory
+	len = strlen(BENCH_CMD) + 2;
+	hdr.length = len;
+	hdr.id = id;
+	hdr.type = DAEMON_RUN;
+	hdr.flags = 0;
+
+	memcpy(buf, &hdr, sizeof(hdr));
+	memcpy(buf + sizeof(hdr), BENCH_CMD, len - 1);
+	buf[sizeof(hdr) + len - 1] = '\0';
+
+	return write(fd, buf, sizeof(hdr) + len) == (ssize_t) (sizeof(hdr) + len);
+}
+
+/**
+ * @brief  Receive replies until a request is done
+ *
+ * @param fd connection to the daemon
+ *
+ * @return   true on success
+ */
+static
+bool daemon_recv(int fd) {
+	struct daemon_hdr_t hdr;
+	char buf[256];
+
+	do {
+		if (! read_all(fd, &hdr, sizeof(hdr)) || hdr.length > sizeof(buf)
+				|| ! read_all(fd, buf, hdr.length))
+			return false;
+	} while (hdr.type == DAEMON_STARTED);
+
+	return hdr.type == DAEMON_EXITED;
+}
+
+/**
+ * @brief  Measure requests of a fresh shell each
+ *
+ * @param n number of requests
+ */
+static
+void bench_shell(int n) {
+	long long * lat;
+	long long start;
+
+	lat = (long long *) malloc(n * sizeof(long long));
+	if (! lat)
+		return;
+
+	for (int i = 0; i < n; ++i) {
+		start = now_ns();
+		if (! run_shell()) {
+			fprintf(stderr, "daemon: %s failed\n", BENCH_SHELL);
+			exit(EXIT_FAILURE);
+		}
+		lat[i] = now_ns() - start;
+	}
+
+	bench_report("daemon", "shell,1", lat, n);
+
+	free(lat);
+}
+
+/**
+ * @brief  Measure requests of the daemon
+ *
+ * @param fd connection to the daemon
+ * @param depth number of requests in flight
+ * @param n number of requests
+ */
+static
+void bench_daemon(int fd, int depth, int n) {
+	char values[64];
+	long long * lat;
+	long long last;
+	int sent = 0;
+	int i;
+
+	lat = (long long *) malloc(n * sizeof(long long));
+	if (! lat)
+		return;
+
+	last = now_ns();
+	for (; sent < depth && sent < n; ++sent)
+		daemon_send(fd, sent);
+
+	for (i = 0; i < n; ++i) {
+		if (! daemon_recv(fd)) {
+			fprintf(stderr, "daemon: request failed\n");
+			exit(EXIT_FAILURE);
+		}
+		lat[i] = now_ns() - last;
+		last += lat[i];
+
+		if (sent < n)
+			daemon_send(fd, sent++);
+	}
+
+	snprintf(values, sizeof(values), "daemon,%d", depth);
+	bench_report("daemon", values, lat, n);
+
+	free(lat);
+}
+
+/**
+ * @brief  main
+ *
+ * @param argc argument count
+ * @param argv[] argument vector: [-j] [iterations]
+ *
+ * @return   EXIT_SUCCESS on success, otherwise EXIT_FAILURE
+ */
+int main(int argc, char * argv[]) {
+	int n = bench_args(argc, argv, 200);
+	char path[64];
+	pid_t pid;
+	int fd;
+
+	snprintf(path, sizeof(path), "/tmp/proj3-bench-%d.sock", getpid());
+
+	if ((fd = daemon_connect(path, &pid)) < 0) {
+		fprintf(stderr, "%s: unable to start %s -d\n", argv[0], BENCH_SHELL);
+		if (pid > 0)
+			kill(pid, SIGTERM);
+		return EXIT_FAILURE;
+	}
+
+	bench_header("mode,depth");
+
+	bench_shell(n);
+	for (size_t d = 0; d < sizeof(DEPTHS) / sizeof(DEPTHS[0]); ++d)
+		bench_daemon(fd, DEPTHS[d], n);
+
+	close(fd);
+	kill(pid, SIGTERM);
+	waitpid(pid, NULL, 0);
+
+	return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,182 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 12:41:20 AM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+#include "../prio.h"
+
+/*
+ * Maximum number of background hogs
+ */
+#define MAX_HOGS					256
+
+static const char * BENCH_PROG		= "/bin/true";
+
+/**
+ * @brief  Background load of a scenario
+ */
+struct scenario_t {
+	const char * name;
+	bool hogs;
+	bool demoted;
+};
+
+static const struct scenario_t SCENARIOS[] = {
+	{ "idle",		false,	false },
+	{ "hogs",		true,		false },
+	{ "demoted",	true,		true },
+};
+
+/*
+ * Loop iterations taking about 1 ms on an idle machine
+ */
+static unsigned long work_loops = 0;
+
+/**
+ * @brief  Burn CPU
+ *
+ * @param loops number of iterations
+ */
+static
+void work(unsigned long loops) {
+	volatile unsigned long x = 0;
+
+	while (loops--)
+		x += loops;
+}
+
+/**
+ * @brief  Calibrate work() to take about 1 ms
+ */
+static
+void calibrate() {
+	const unsigned long loops = 1 << 20;
+	long long start, best = 0, t;
+
+	for (int i = 0; i < 10; ++i) {
+		start = now_ns();
+		work(loops);
+		t = now_ns() - start;
+		if (! best || t < best)
+			best = t;
+	}
+
+	work_loops = loops * 1000000LL / (best ? best : 1);
+}
+
+/**
+ * @brief  Foreground task: spawn BENCH_PROG and wait for it
+ */
+static
+void task_spawn() {
+	pid_t pid = vfork();
+
+	if (pid == 0) {
+		execl(BENCH_PROG, BENCH_PROG, (char *) NULL);
+		_exit(127);
+	}
+
+	if (pid > 0)
+		waitpid(pid, NULL, 0);
+}
+
+/**
+ * @brief  Foreground task: 1 ms of CPU work
+ */
+static
+void task_work() {
+	work(work_loops);
+}
+
+/**
+ * @brief  Measure latency of a foreground task
+ *
+ * @param scenario scenario name, reported only
+ * @param name task name, reported only
+ * @param task task to run
+ * @param n number of iterations
+ */
+static
+void bench_task(const char * scenario, const char * name, void (* task)(), int n) {
+	char values[64];
+	long long * lat;
+	long long start;
+	int i;
+
+	lat = (long long *) malloc(n * sizeof(long long));
+	if (! lat)
+		return;
+
+	for (i = 0; i < n; ++i) {
+		start = now_ns();
+		task();
+		lat[i] = now_ns() - start;
+	}
+
+	snprintf(values, sizeof(values), "%s,%s", scenario, name);
+	bench_report("latency", values, lat, n);
+
+	free(lat);
+}
+
+/**
+ * @brief  main
+ *
+ * @param argc argument count
+ * @param argv[] argument vector: [-j] [iterations]
+ *
+ * @return   EXIT_SUCCESS on success, otherwise EXIT_FAILURE
+ */
+int main(int argc, char * argv[]) {
+	pid_t hogs[MAX_HOGS];
+	long nhogs;
+	int n = bench_args(argc, argv, 200);
+	int i, started;
+
+	nhogs = 2 * sysconf(_SC_NPROCESSORS_ONLN);
+	if (nhogs <= 0 || nhogs > MAX_HOGS)
+		nhogs = MAX_HOGS;
+
+	calibrate();
+
+	bench_header("scenario,task");
+
+	for (size_t s = 0; s < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); ++s) {
+		for (started = 0; SCENARIOS[s].hogs && started < nhogs; ++started) {
+			if ((hogs[started] = fork()) < 0) {
+				break;
+			} else if (hogs[started] == 0) {
+				if (SCENARIOS[s].demoted)
+					prio_apply(prio_background(), 0);
+				for (;;)
+					work(work_loops);
+			}
+		}
+
+		usleep(100000); // let the hogs saturate CPUs
+
+		bench_task(SCENARIOS[s].name, "spawn", task_spawn, n);
+		bench_task(SCENARIOS[s].name, "work_1ms", task_work, n);
+
+		for (i = 0; i < started; ++i) {
+			kill(hogs[i], SIGKILL);
+			waitpid(hogs[i], NULL, 0);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,167 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 03:34:52 AM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+/*
+ * get_token() is static, benchmark it in the same translation unit
+ */
+#include "../parse.c"
+
+/*
+ * Operations timed together per sample, a single parse is too short
+ * for the clock
+ */
+#define PARSE_BATCH					64
+
+/**
+ * @brief  Input line of a case
+ */
+struct line_t {
+	const char * name;
+	char text[BUF_SIZE];
+};
+
+static struct line_t LINES[] = {
+	{ "short",			"ls -la /tmp" },
+	{ "redirect",		"sort -u -k2 < in.txt > out.txt &" },
+	{ "long",			"" },		// many ordinary tokens, filled by lines_init()
+	{ "one_token",		"" },		// a single token as long as allowed
+	{ "one_char",		"" },		// single character tokens
+	{ "blanks",			"" },		// mostly whitespace
+};
+
+/**
+ * @brief  Fill long and pathological lines up to BUF_SIZE - 1 characters
+ */
+static
+void lines_init() {
+	const size_t max = BUF_SIZE - 2; // '\n' is stripped by the reader
+	char * s;
+	size_t i;
+
+	s = LINES[2].text;
+	for (i = 0; i + 8 < max; i += 8)
+		memcpy(s + i, "arg_xyz ", 8);
+	s[i] = '\0';
+
+	s = LINES[3].text;
+	memset(s, 'x', max);
+	s[max] = '\0';
+
+	s = LINES[4].text;
+	for (i = 0; i + 2 < max; i += 2)
+		memcpy(s + i, "a ", 2);
+	s[i] = '\0';
+
+	s = LINES[5].text;
+	for (i = 0; i < max - 1; ++i)
+		s[i] = i % 2 ? '\t' : ' ';
+	s[i] = 'x';
+	s[i + 1] = '\0';
+}
+
+/**
+ * @brief  Tokenize line using get_token() only
+ *
+ * @param line line to tokenize
+ */
+static
+void op_tokens(const char * line) {
+	char * token = NULL;
+	int start = 0;
+	int disp;
+
+	while ((disp = get_token(&token, &line[start]))) {
+		if (IS_TKN_BG(disp))
+			start += GET_DISP_TKN_BG(disp);
+		else if (IS_TKN_IN(disp))
+			start += GET_DISP_TKN_IN(disp);
+		else if (IS_TKN_OUT(disp))
+			start += GET_DISP_TKN_OUT(disp);
+		else {
+			free(token);
+			start += disp;
+		}
+	}
+}
+
+/**
+ * @brief  Parse line using parse_command()
+ *
+ * @param line line to parse
+ */
+static
+void op_parse(const char * line) {
+	struct parse_list_t cmd_list;
+
+	if (parse_command(&cmd_list, line))
+		parse_free(&cmd_list);
+}
+
+/**
+ * @brief  Measure latency of an operation on a line
+ *
+ * @param name operation name, reported only
+ * @param op operation
+ * @param line line to use
+ * @param n number of samples
+ */
+static
+void bench_op(const char * name, void (* op)(const char *),
+				const struct line_t * line, int n) {
+	char values[64];
+	long long * lat;
+	long long start;
+
+	lat = (long long *) malloc(n * sizeof(long long));
+	if (! lat)
+		return;
+
+	for (int i = 0; i < n; ++i) {
+		start = now_ns();
+		for (int j = 0; j < PARSE_BATCH; ++j)
+			op(line->text);
+		lat[i] = (now_ns() - start) / PARSE_BATCH;
+	}
+
+	snprintf(values, sizeof(values), "%s,%s,%zu", name, line->name,
+			strlen(line->text));
+	bench_report("parse", values, lat, n);
+
+	free(lat);
+}
+
+/**
+ * @brief  main
+ *
+ * @param argc argument count
+ * @param argv[] argument vector: [-j] [iterations]
+ *
+ * @return   EXIT_SUCCESS on success, otherwise EXIT_FAILURE
+ */
+int main(int argc, char * argv[]) {
+	int n = bench_args(argc, argv, 1000);
+
+	lines_init();
+
+	bench_header("op,line,length");
+
+	for (size_t l = 0; l < sizeof(LINES) / sizeof(LINES[0]); ++l) {
+		bench_op("get_token", op_tokens, &LINES[l], n);
+		bench_op("parse_command", op_parse, &LINES[l], n);
+	}
+
+	return EXIT_SUCCESS;
+}
+
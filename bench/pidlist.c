@@ -0,0 +1,195 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 03:41:15 AM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "../pidlist.h"
+
+/*
+ * Number of jobs in the table
+ */
+static const int SIZES[] = { 10, 1000, 100000 };
+
+/*
+ * Operations timed together per sample, big tables are slow enough alone
+ */
+#define PIDLIST_BATCH				16
+
+/*
+ * PIDs of jobs are 1..size, spread over the list in random order
+ */
+static pid_t * pids = NULL;
+
+/**
+ * @brief  Fill table with jobs 1..size in random order
+ *
+ * @param pidlist table to fill
+ * @param size number of jobs
+ *
+ * @return   true on success
+ */
+static
+bool table_fill(struct pidlist_t * pidlist, int size) {
+	pid_t tmp;
+	int i, j;
+
+	pids = (pid_t *) realloc(pids, size * sizeof(pid_t));
+	if (! pids)
+		return false;
+
+	for (i = 0; i < size; ++i)
+		pids[i] = i + 1;
+
+	for (i = size - 1; i > 0; --i) {
+		j = rand() % (i + 1);
+		tmp = pids[i]; pids[i] = pids[j]; pids[j] = tmp;
+	}
+
+	pidlist_init(pidlist);
+	for (i = 0; i < size; ++i)
+		if (! pidlist_insert(pidlist, pids[i]))
+			return false;
+
+	return true;
+}
+
+/**
+ * @brief  Free all jobs without signalling them
+ *
+ * @param pidlist table to free
+ */
+static
+void table_free(struct pidlist_t * pidlist) {
+	struct pidlist_item_t * it;
+
+	while ((it = pidlist->first)) {
+		pidlist->first = it->next;
+		free(it);
+	}
+}
+
+/**
+ * @brief  Insert a job and remove it again, the table keeps its size
+ *
+ * @param pidlist table to use
+ * @param size number of jobs
+ */
+static
+void op_insert(struct pidlist_t * pidlist, int size) {
+	struct pidlist_item_t * item = pidlist_insert(pidlist, size + 1);
+
+	// new jobs are at the head, removing it is cheap
+	pidlist->first = item->next;
+	free(item);
+}
+
+/**
+ * @brief  Find a random job
+ *
+ * @param pidlist table to use
+ * @param size number of jobs
+ */
+static
+void op_find(struct pidlist_t * pidlist, int size) {
+	if (! pidlist_find(pidlist, rand() % size + 1))
+		abort();
+}
+
+/**
+ * @brief  Remove a random job as the SIGCHLD handler does and insert it
+ *         again at the head
+ *
+ * @param pidlist table to use
+ * @param size number of jobs
+ */
+static
+void op_remove(struct pidlist_t * pidlist, int size) {
+	struct pidlist_item_t * item = pidlist_find(pidlist, rand() % size + 1);
+
+	pidlist_remove(pidlist, item);
+	item->next = pidlist->first;
+	pidlist->first = item;
+}
+
+/**
+ * @brief  Table operation
+ */
+struct op_t {
+	const char * name;
+	void (* op)(struct pidlist_t * pidlist, int size);
+};
+
+static const struct op_t OPS[] = {
+	{ "insert",		op_insert },
+	{ "find",		op_find },
+	{ "remove",		op_remove },
+};
+
+/**
+ * @brief  Measure latency of an operation
+ *
+ * @param op operation to measure
+ * @param size number of jobs
+ * @param n number of samples
+ */
+static
+void bench_op(const struct op_t * op, int size, int n) {
+	struct pidlist_t pidlist;
+	int batch = size > 1000 ? 1 : PIDLIST_BATCH;
+	char values[64];
+	long long * lat;
+	long long start;
+
+	lat = (long long *) malloc(n * sizeof(long long));
+	if (! lat || ! table_fill(&pidlist, size)) {
+		free(lat);
+		return;
+	}
+
+	for (int i = 0; i < n; ++i) {
+		start = now_ns();
+		for (int j = 0; j < batch; ++j)
+			op->op(&pidlist, size);
+		lat[i] = (now_ns() - start) / batch;
+	}
+
+	snprintf(values, sizeof(values), "%s,%d", op->name, size);
+	bench_report("pidlist", values, lat, n);
+
+	table_free(&pidlist);
+	free(lat);
+}
+
+/**
+ * @brief  main
+ *
+ * @param argc argument count
+ * @param argv[] argument vector: [-j] [iterations]
+ *
+ * @return   EXIT_SUCCESS on success, otherwise EXIT_FAILURE
+ */
+int main(int argc, char * argv[]) {
+	int n = bench_args(argc, argv, 200);
+
+	srand(1); // same tables in every run
+
+	bench_header("op,jobs");
+
+	for (size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); ++s)
+		for (size_t o = 0; o < sizeof(OPS) / sizeof(OPS[0]); ++o)
+			bench_op(&OPS[o], SIZES[s], n);
+
+	free(pids);
+
+	return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,186 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/20/2026 10:12:37 AM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+#include "../place.h"
+#include "../pidlist.h"
+
+/*
+ * Policies compared, "none" runs jobs unpinned
+ */
+static const char * POLICIES[] = { "none", "rr", "pack", "spread" };
+
+/*
+ * Loop iterations of a CPU bound job
+ */
+#define CPU_LOOPS					(1UL << 27)
+
+/*
+ * Memory touched by a memory bound job and passes over it
+ */
+#define MEM_SIZE					(32UL << 20)
+#define MEM_PASSES				8
+
+/**
+ * @brief  Job of a workload
+ */
+struct workload_t {
+	const char * name;
+	void (* job)();
+};
+
+/**
+ * @brief  CPU bound job
+ */
+static
+void job_cpu() {
+	volatile unsigned long x = 0;
+
+	for (unsigned long i = CPU_LOOPS; i > 0; --i)
+		x += i;
+}
+
+/**
+ * @brief  Memory bound job, allocated after placement so pages are local
+ */
+static
+void job_mem() {
+	volatile unsigned long sum = 0;
+	unsigned long * buf;
+	size_t n = MEM_SIZE / sizeof(unsigned long);
+
+	if (! (buf = (unsigned long *) malloc(MEM_SIZE)))
+		_exit(EXIT_FAILURE);
+
+	for (size_t i = 0; i < n; ++i)
+		buf[i] = i;
+
+	for (int pass = 0; pass < MEM_PASSES; ++pass)
+		for (size_t i = 0; i < n; i += 8) // one access per cache line
+			sum += buf[i];
+}
+
+static const struct workload_t WORKLOADS[] = {
+	{ "cpu",		job_cpu },
+	{ "mem",		job_mem },
+};
+
+/**
+ * @brief  Run jobs placed as the shell would and wait for all of them
+ *
+ * @param workload job to run
+ * @param njobs number of jobs
+ *
+ * @return   false if a job failed
+ */
+static
+bool run_jobs(const struct workload_t * workload, int njobs) {
+	struct pidlist_t jobs;
+	struct pidlist_item_t * item;
+	struct place_t place;
+	bool ok = true;
+	int status;
+	pid_t pid;
+
+	pidlist_init(&jobs);
+
+	for (int i = 0; i < njobs; ++i) {
+		place_init(&place);
+		place_next(&place, &jobs); // sees jobs placed so far
+
+		if ((pid = fork()) < 0) {
+			perror("fork failed");
+			ok = false;
+			break;
+		} else if (pid == 0) {
+			if (! place_apply(&place))
+				_exit(EXIT_FAILURE);
+			workload->job();
+			_exit(EXIT_SUCCESS);
+		}
+
+		if (! (item = pidlist_insert(&jobs, pid))) {
+			waitpid(pid, NULL, 0);
+			ok = false;
+			break;
+		}
+		item->place = place;
+	}
+
+	while ((item = jobs.first)) {
+		if (waitpid(item->pid, &status, 0) < 0 || ! WIFEXITED(status)
+				|| WEXITSTATUS(status) != EXIT_SUCCESS)
+			ok = false;
+		pidlist_remove(&jobs, item);
+		free(item);
+	}
+
+	return ok;
+}
+
+/**
+ * @brief  main
+ *
+ * @param argc argument count
+ * @param argv[] argument vector: [-j] [iterations]
+ *
+ * @return   EXIT_SUCCESS on success, otherwise EXIT_FAILURE
+ */
+int main(int argc, char * argv[]) {
+	int n = bench_args(argc, argv, 5);
+	char values[64];
+	long long * lat;
+	long long start;
+	cpu_set_t allowed;
+	int njobs;
+
+	if (! place_topology_init()
+			|| sched_getaffinity(0, sizeof(allowed), &allowed) < 0)
+		return EXIT_FAILURE;
+
+	// one job per CPU, placement matters once they compete
+	njobs = CPU_COUNT(&allowed);
+
+	if (! (lat = (long long *) malloc(n * sizeof(long long))))
+		return EXIT_FAILURE;
+
+	bench_header("policy,workload,jobs");
+
+	for (size_t w = 0; w < sizeof(WORKLOADS) / sizeof(WORKLOADS[0]); ++w) {
+		for (size_t p = 0; p < sizeof(POLICIES) / sizeof(POLICIES[0]); ++p) {
+			place_set_policy(POLICIES[p]);
+
+			for (int i = 0; i < n; ++i) {
+				start = now_ns();
+				if (! run_jobs(&WORKLOADS[w], njobs)) {
+					fprintf(stderr, "place: %s jobs failed\n", WORKLOADS[w].name);
+					return EXIT_FAILURE;
+				}
+				lat[i] = now_ns() - start;
+			}
+
+			snprintf(values, sizeof(values), "%s,%s,%d",
+					POLICIES[p], WORKLOADS[w].name, njobs);
+			bench_report("place", values, lat, n);
+		}
+	}
+
+	free(lat);
+
+	return EXIT_SUCCESS;
+}
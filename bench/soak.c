@@ -0,0 +1,578 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 04:27:03 AM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+#include "../proj3.h"
+
+/*
+ * Soak test: drive the shell through a pty (or pipes) with a synthetic or
+ * recorded command stream and watch it over time. The next line is sent
+ * once the shell printed its prompt, at a given rate or flat-out; prompt
+ * latency is the time from writing a line to the next prompt. Every
+ * interval one row is printed with throughput, latency percentiles and
+ * zombies, open fds and RSS of the shell. A shell not prompting within the
+ * hang timeout or exiting on its own fails the run.
+ */
+
+#define SOAK_DURATION_S			10
+#define SOAK_INTERVAL_S			1
+#define SOAK_HANG_MS				5000
+#define SOAK_MAX_LINE			1024
+
+/*
+ * Prompt latencies kept per interval, the rest is dropped from percentiles
+ */
+#define SOAK_MAX_SAMPLES		(1 << 20)
+
+static const char * SOAK_SHELL	= "./proj3";
+static const char * SOAK_TMP		= "/tmp/proj3-soak";
+
+static const char * ERR_HANG		= "soak: no prompt for %d ms after line %lu: %s\n";
+static const char * ERR_DIED		= "soak: shell gone after line %lu: %s\n";
+
+/**
+ * @brief  Kind of a synthetic line
+ */
+struct mix_t {
+	const char * fmt;		// %d is replaced by a random number
+	int weight;
+};
+
+static const struct mix_t MIX[] = {
+	// foreground
+	{ "true",								20 },
+	{ "echo hello %d",					10 },
+	{ "ls /",								5 },
+	// background, short lived to keep SIGCHLD busy
+	{ "sleep 0.0%d &",					15 },
+	{ "true &",								10 },
+	// redirections
+	{ "echo %d > %s.out",				8 },
+	{ "cat < %s.out",						8 },
+	{ "sort < %s.out > %s.sorted &",	4 },
+	// malformed
+	{ "> >",									3 },
+	{ "cat <",								3 },
+	{ "true & &",							3 },
+	{ "echo a > b > c",					3 },
+	{ "no-such-command-%d",				3 },
+	{ "",										2 },		// too long, filled in
+};
+
+/**
+ * @brief  Options and state of a run
+ */
+struct soak_t {
+	// options
+	bool use_pipe;
+	double rate;				// lines per second, 0 for flat-out
+	long duration_s;
+	long interval_s;
+	int hang_ms;
+	FILE * script;				// recorded stream or NULL for synthetic
+	bool json;
+
+	// shell
+	pid_t pid;
+	int fd_in;
+	int fd_out;
+
+	// prompt detection
+	char last;					// last byte of output seen
+	bool prompt;
+
+	// current interval
+	unsigned long lines;
+	unsigned long total;
+	long long * lat;
+	int nlat;
+};
+
+/**
+ * @brief  Fill line with the next synthetic command
+ *
+ * @param line where to store line
+ * @param len size of line
+ */
+static
+void next_synthetic(char * line, size_t len) {
+	static int total_weight = 0;
+	const struct mix_t * m;
+	int pick, i;
+
+	if (! total_weight)
+		for (i = 0; i < (int) (sizeof(MIX) / sizeof(MIX[0])); ++i)
+			total_weight += MIX[i].weight;
+
+	pick = rand() % total_weight;
+	for (m = MIX; pick >= m->weight; ++m)
+		pick -= m->weight;
+
+	if (! *m->fmt) { // longer than the shell accepts
+		len = BUF_SIZE + 64 < len ? BUF_SIZE + 64 : len - 1;
+		memset(line, 'x', len);
+		line[len] = '\0';
+		return;
+	}
+
+	if (strstr(m->fmt, "%d"))
+		snprintf(line, len, m->fmt, rand() % 10, SOAK_TMP);
+	else
+		snprintf(line, len, m->fmt, SOAK_TMP, SOAK_TMP);
+}
+
+/**
+ * @brief  Get next line of the stream
+ *
+ * @param soak run to use
+ * @param line where to store line
+ * @param len size of line
+ */
+static
+void next_line(struct soak_t * soak, char * line, size_t len) {
+	if (soak->script) {
+		if (! fgets(line, len, soak->script)) { // replay again
+			rewind(soak->script);
+			if (! fgets(line, len, soak->script))
+				line[0] = '\0';
+		}
+		line[strcspn(line, "\n")] = '\0';
+		return;
+	}
+
+	next_synthetic(line, len);
+}
+
+/**
+ * @brief  Start the shell
+ *
+ * @param soak run to use
+ * @param argv shell and its arguments
+ *
+ * @return   true on success
+ */
+static
+bool shell_start(struct soak_t * soak, char ** argv) {
+	struct termios tio;
+	int in[2], out[2];
+	int master;
+
+	if (! soak->use_pipe) {
+		// line mode without echo, typed lines must not be taken for output
+		memset(&tio, 0, sizeof(tio));
+		tio.c_cflag = CS8 | CREAD;
+		tio.c_lflag = ICANON;
+		tio.c_cc[VEOF] = 4;
+		tio.c_cc[VMIN] = 1;
+
+		soak->pid = forkpty(&master, NULL, &tio, NULL);
+		if (soak->pid == 0) {
+			execvp(argv[0], argv);
+			_exit(127);
+		}
+		soak->fd_in = soak->fd_out = master;
+	} else {
+		if (pipe2(in, O_CLOEXEC) < 0 || pipe2(out, O_CLOEXEC) < 0) {
+			perror("pipe");
+			return false;
+		}
+
+		soak->pid = fork();
+		if (soak->pid == 0) {
+			dup2(in[0], STDIN_FILENO);
+			dup2(out[1], STDOUT_FILENO);
+			dup2(out[1], STDERR_FILENO);
+			execvp(argv[0], argv);
+			_exit(127);
+		}
+		close(in[0]);
+		close(out[1]);
+		soak->fd_in = in[1];
+		soak->fd_out = out[0];
+	}
+
+	if (soak->pid < 0) {
+		perror("fork");
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Read output of the shell, look for a prompt
+ *
+ * @param soak run to use
+ * @param timeout_ms how long to wait for output
+ *
+ * @return   false if the shell closed its output
+ */
+static
+bool shell_read(struct soak_t * soak, int timeout_ms) {
+	struct pollfd pfd = { .fd = soak->fd_out, .events = POLLIN };
+	char buf[4096];
+	ssize_t len;
+
+	if (poll(&pfd, 1, timeout_ms) <= 0)
+		return true;
+
+	len = read(soak->fd_out, buf, sizeof(buf));
+	if (len <= 0)
+		return false;
+
+	// prompt follows a newline or another prompt; the line editor redraws
+	// the line after '\r' on every key, a new one is empty (clear to EOL)
+	for (ssize_t i = 0; i < len; ++i) {
+		if ((buf[i] == '$' || buf[i] == '#') && i + 1 < len && buf[i + 1] == ' '
+				&& (soak->last == '\n' || soak->last == ' ' || soak->last == '\0'
+					|| (soak->last == '\r' && i + 2 < len && buf[i + 2] == '\x1b')))
+			soak->prompt = true;
+		soak->last = buf[i];
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Wait for prompt
+ *
+ * @param soak run to use
+ * @param timeout_ms how long to wait
+ *
+ * @return   false on timeout or if the shell is gone
+ */
+static
+bool wait_prompt(struct soak_t * soak, int timeout_ms) {
+	long long deadline = now_ns() + timeout_ms * 1000000LL;
+	long long left;
+
+	while (! soak->prompt) {
+		left = (deadline - now_ns()) / 1000000;
+		if (left <= 0)
+			return false;
+		if (! shell_read(soak, left))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Count zombie children of a process
+ *
+ * @param pid parent
+ *
+ * @return   number of zombies
+ */
+static
+int count_zombies(pid_t pid) {
+	char path[64], buf[512];
+	struct dirent * ent;
+	int zombies = 0;
+	int child;
+	int ppid;
+	char state;
+	char * c;
+	DIR * dir;
+	FILE * f;
+
+	if (! (dir = opendir("/proc")))
+		return -1;
+
+	while ((ent = readdir(dir))) {
+		if ((child = atoi(ent->d_name)) <= 0)
+			continue;
+
+		snprintf(path, sizeof(path), "/proc/%d/stat", child);
+		if (! (f = fopen(path, "r")))
+			continue;
+
+		// comm may contain spaces, fields follow the last ')'
+		if (fgets(buf, sizeof(buf), f) && (c = strrchr(buf, ')'))
+				&& sscanf(c + 1, " %c %d", &state, &ppid) == 2
+				&& ppid == pid && state == 'Z')
+			zombies++;
+		fclose(f);
+	}
+
+	closedir(dir);
+
+	return zombies;
+}
+
+/**
+ * @brief  Count open fds of a process
+ *
+ * @param pid process to use
+ *
+ * @return   number of fds
+ */
+static
+int count_fds(pid_t pid) {
+	char path[64];
+	struct dirent * ent;
+	int fds = 0;
+	DIR * dir;
+
+	snprintf(path, sizeof(path), "/proc/%d/fd", pid);
+	if (! (dir = opendir(path)))
+		return -1;
+
+	while ((ent = readdir(dir)))
+		if (ent->d_name[0] != '.')
+			fds++;
+
+	closedir(dir);
+
+	return fds;
+}
+
+/**
+ * @brief  Get resident set size of a process
+ *
+ * @param pid process to use
+ *
+ * @return   RSS in KiB
+ */
+static
+long rss_kb(pid_t pid) {
+	char path[64];
+	long size, rss = -1;
+	FILE * f;
+
+	snprintf(path, sizeof(path), "/proc/%d/statm", pid);
+	if (! (f = fopen(path, "r")))
+		return -1;
+
+	if (fscanf(f, "%ld %ld", &size, &rss) != 2)
+		rss = -1;
+	fclose(f);
+
+	return rss < 0 ? -1 : rss * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/**
+ * @brief  Print row of an interval and start the next one
+ *
+ * @param soak run to use
+ * @param elapsed_ns time since start
+ * @param interval_ns length of the interval
+ */
+static
+void report(struct soak_t * soak, long long elapsed_ns, long long interval_ns) {
+	long long p50 = 0, p99 = 0, max = 0;
+	int zombies = count_zombies(soak->pid);
+	int fds = count_fds(soak->pid);
+	long rss = rss_kb(soak->pid);
+	double rate = interval_ns ? soak->lines * 1e9 / interval_ns : 0;
+
+	if (soak->nlat) {
+		qsort(soak->lat, soak->nlat, sizeof(long long), cmp_ll);
+		p50 = soak->lat[soak->nlat / 2];
+		p99 = soak->lat[soak->nlat * 99 / 100];
+		max = soak->lat[soak->nlat - 1];
+	}
+
+	if (soak->json)
+		printf("{\"bench\":\"soak\",\"elapsed_s\":%.1f,\"lines\":%lu,\"lines_per_s\":%.1f,"
+				"\"p50_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f,"
+				"\"zombies\":%d,\"fds\":%d,\"rss_kb\":%ld}\n",
+				elapsed_ns / 1e9, soak->total, rate, p50 / 1000.0, p99 / 1000.0,
+				max / 1000.0, zombies, fds, rss);
+	else
+		printf("soak,%.1f,%lu,%.1f,%.1f,%.1f,%.1f,%d,%d,%ld\n",
+				elapsed_ns / 1e9, soak->total, rate, p50 / 1000.0, p99 / 1000.0,
+				max / 1000.0, zombies, fds, rss);
+	fflush(stdout);
+
+	soak->lines = 0;
+	soak->nlat = 0;
+}
+
+/**
+ * @brief  Print usage
+ *
+ * @param pname program name
+ *
+ * @return   always 2
+ */
+static
+int print_help(const char * pname) {
+	fprintf(stderr,
+			"Usage: %s [-p] [-r RATE] [-d SECONDS] [-i SECONDS] [-t MS] [-s SEED]\n"
+			"          [-f SCRIPT] [-j] [-- SHELL [ARGS...]]\n"
+			"  -p  drive the shell through pipes instead of a pty\n"
+			"  -r  lines per second, flat-out by default\n"
+			"  -d  duration (default %d s), -i report interval (default %d s)\n"
+			"  -t  fail if no prompt comes within MS (default %d ms)\n"
+			"  -s  seed of the synthetic stream, -f replay lines of SCRIPT instead\n"
+			"  -j  JSON lines instead of CSV\n",
+			pname, SOAK_DURATION_S, SOAK_INTERVAL_S, SOAK_HANG_MS);
+
+	return 2;
+}
+
+/**
+ * @brief  main
+ *
+ * @param argc argument count
+ * @param argv[] argument vector
+ *
+ * @return   0 on success, 1 if the shell hung or died, 2 on error
+ */
+int main(int argc, char * argv[]) {
+	char * shell_argv[] = { (char *) SOAK_SHELL, NULL };
+	char ** shell = shell_argv;
+	struct soak_t soak;
+	char line[SOAK_MAX_LINE];
+	long long start, now, sent, last_report, next_send;
+	int status, opt;
+	bool ok = true;
+
+	memset(&soak, 0, sizeof(soak));
+	soak.duration_s = SOAK_DURATION_S;
+	soak.interval_s = SOAK_INTERVAL_S;
+	soak.hang_ms = SOAK_HANG_MS;
+	srand(1);
+
+	while ((opt = getopt(argc, argv, "pr:d:i:t:s:f:j")) != -1) {
+		switch (opt) {
+			case 'p': soak.use_pipe = true; break;
+			case 'r': soak.rate = atof(optarg); break;
+			case 'd': soak.duration_s = atol(optarg); break;
+			case 'i': soak.interval_s = atol(optarg); break;
+			case 't': soak.hang_ms = atoi(optarg); break;
+			case 's': srand(atoi(optarg)); break;
+			case 'j': soak.json = true; break;
+			case 'f':
+				if (! (soak.script = fopen(optarg, "r"))) {
+					perror(optarg);
+					return 2;
+				}
+				break;
+			default:
+				return print_help(argv[0]);
+		}
+	}
+
+	if (optind < argc)
+		shell = &argv[optind];
+
+	if (soak.duration_s <= 0 || soak.interval_s <= 0 || soak.hang_ms <= 0)
+		return print_help(argv[0]);
+
+	soak.lat = (long long *) malloc(SOAK_MAX_SAMPLES * sizeof(long long));
+	if (! soak.lat)
+		return 2;
+
+	signal(SIGPIPE, SIG_IGN);
+
+	if (! shell_start(&soak, shell))
+		return 2;
+
+	if (! soak.json)
+		printf("bench,elapsed_s,lines,lines_per_s,p50_us,p99_us,max_us,zombies,fds,rss_kb\n");
+
+	if (! wait_prompt(&soak, soak.hang_ms)) {
+		fprintf(stderr, ERR_HANG, soak.hang_ms, 0UL, "(start)");
+		ok = false;
+	}
+
+	start = last_report = next_send = now_ns();
+
+	while (ok && (now = now_ns()) - start < soak.duration_s * 1000000000LL) {
+		if (soak.rate > 0 && now < next_send) {
+			shell_read(&soak, (next_send - now) / 1000000 + 1);
+			continue;
+		}
+
+		next_line(&soak, line, sizeof(line) - 1);
+		strcat(line, "\n");
+
+		soak.prompt = false;
+		sent = now_ns();
+		if (write(soak.fd_in, line, strlen(line)) < 0) {
+			line[strcspn(line, "\n")] = '\0';
+			fprintf(stderr, ERR_DIED, soak.total, line);
+			ok = false;
+			break;
+		}
+
+		if (! wait_prompt(&soak, soak.hang_ms)) {
+			line[strcspn(line, "\n")] = '\0';
+			if (waitpid(soak.pid, &status, WNOHANG) == soak.pid) {
+				fprintf(stderr, ERR_DIED, soak.total, line);
+				soak.pid = -1;
+			} else {
+				fprintf(stderr, ERR_HANG, soak.hang_ms, soak.total, line);
+			}
+			ok = false;
+			break;
+		}
+
+		if (soak.nlat < SOAK_MAX_SAMPLES)
+			soak.lat[soak.nlat++] = now_ns() - sent;
+		soak.lines++;
+		soak.total++;
+
+		if (soak.rate > 0)
+			next_send += (long long) (1e9 / soak.rate);
+
+		if ((now = now_ns()) - last_report >= soak.interval_s * 1000000000LL) {
+			report(&soak, now - start, now - last_report);
+			last_report = now;
+		}
+	}
+
+	if (soak.lines)
+		report(&soak, now_ns() - start, now_ns() - last_report);
+
+	if (ok) {
+		write(soak.fd_in, "exit\n", 5);
+		sent = now_ns();
+		while (waitpid(soak.pid, &status, WNOHANG) == 0) {
+			if (now_ns() - sent > soak.hang_ms * 1000000LL) {
+				fprintf(stderr, ERR_HANG, soak.hang_ms, soak.total, "exit");
+				kill(soak.pid, SIGKILL);
+				waitpid(soak.pid, &status, 0);
+				ok = false;
+				break;
+			}
+			shell_read(&soak, 10); // keep the pty drained
+		}
+	} else if (soak.pid > 0) {
+		kill(soak.pid, SIGKILL);
+		waitpid(soak.pid, &status, 0);
+	}
+
+	if (ok && ! (WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+		fprintf(stderr, "soak: shell exited with status %d\n", status);
+		ok = false;
+	}
+
+	free(soak.lat);
+
+	return ok ? 0 : 1;
+}
+
@@ -0,0 +1,206 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 09:48:13 PM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <spawn.h>
+
+#include "bench.h"
+#include "../zygote.h"
+
+/*
+ * Heap sizes (MiB) the process is grown to between runs
+ */
+static const size_t HEAP_MB[] = { 0, 256, 1024 };
+
+static const char * BENCH_PROG		= "/bin/true";
+static const char * BENCH_PROG_PATH	= "true";			// looked up in PATH
+
+extern char ** environ;
+
+/**
+ * @brief  Spawn method
+ */
+struct method_t {
+	const char * name;
+	pid_t (* spawn)(char ** argv);
+};
+
+/**
+ * @brief  Spawn using fork() and execv()
+ */
+static
+pid_t spawn_fork(char ** argv) {
+	pid_t pid = fork();
+
+	if (pid == 0) {
+		execv(argv[0], argv);
+		_exit(127);
+	}
+
+	return pid;
+}
+
+/**
+ * @brief  Spawn using vfork() and execv(), as the shell does by default
+ */
+static
+pid_t spawn_vfork(char ** argv) {
+	pid_t pid = vfork();
+
+	if (pid == 0) {
+		execv(argv[0], argv);
+		_exit(127);
+	}
+
+	return pid;
+}
+
+/**
+ * @brief  Spawn using vfork() and execvp(), argv[0] is looked up in PATH
+ *         as the shell does
+ */
+static
+pid_t spawn_vfork_path(char ** argv) {
+	pid_t pid = vfork();
+
+	(void) argv;
+
+	if (pid == 0) {
+		execlp(BENCH_PROG_PATH, BENCH_PROG_PATH, (char *) NULL);
+		_exit(127);
+	}
+
+	return pid;
+}
+
+/**
+ * @brief  Spawn using posix_spawnp(), argv[0] is looked up in PATH
+ */
+static
+pid_t spawn_posix_path(char ** argv) {
+	char * path_argv[] = { (char *) BENCH_PROG_PATH, NULL };
+	pid_t pid;
+
+	(void) argv;
+
+	if (posix_spawnp(&pid, BENCH_PROG_PATH, NULL, NULL, path_argv, environ) != 0)
+		return -1;
+
+	return pid;
+}
+
+/**
+ * @brief  Spawn using posix_spawn()
+ */
+static
+pid_t spawn_posix(char ** argv) {
+	pid_t pid;
+
+	if (posix_spawn(&pid, argv[0], NULL, NULL, argv, environ) != 0)
+		return -1;
+
+	return pid;
+}
+
+/**
+ * @brief  Spawn using the fork server
+ */
+static
+pid_t spawn_zygote(char ** argv) {
+	struct spawn_attr_t attr;
+
+	spawn_attr_init(&attr);
+
+	return zygote_spawn(argv, &attr, NULL);
+}
+
+static const struct method_t METHODS[] = {
+	{ "fork",			spawn_fork },
+	{ "vfork",			spawn_vfork },
+	{ "vfork_execvp",	spawn_vfork_path },
+	{ "posix_spawn",	spawn_posix },
+	{ "posix_spawnp",	spawn_posix_path },
+	{ "zygote",			spawn_zygote },
+};
+
+/**
+ * @brief  Measure spawn latency (until the spawn call returns)
+ *
+ * @param method method to use
+ * @param heap_mb current heap size, reported only
+ * @param n number of iterations
+ */
+static
+void bench_method(const struct method_t * method, size_t heap_mb, int n) {
+	char * argv[] = { (char *) BENCH_PROG, NULL };
+	char values[64];
+	long long * lat;
+	long long start;
+	pid_t pid;
+	int i;
+
+	lat = (long long *) malloc(n * sizeof(long long));
+	if (! lat)
+		return;
+
+	for (i = 0; i < n; ++i) {
+		start = now_ns();
+		pid = method->spawn(argv);
+		lat[i] = now_ns() - start;
+		if (pid > 0)
+			waitpid(pid, NULL, 0);
+	}
+
+	snprintf(values, sizeof(values), "%s,%zu", method->name, heap_mb);
+	bench_report("spawn", values, lat, n);
+
+	free(lat);
+}
+
+/**
+ * @brief  main
+ *
+ * @param argc argument count
+ * @param argv[] argument vector: [-j] [iterations]
+ *
+ * @return   EXIT_SUCCESS on success, otherwise EXIT_FAILURE
+ */
+int main(int argc, char * argv[]) {
+	int n = bench_args(argc, argv, 200);
+	size_t m, h, grown = 0;
+	char * heap;
+
+	if (! zygote_start()) // as the shell does, while still small
+		return EXIT_FAILURE;
+
+	bench_header("method,heap_mb");
+
+	for (h = 0; h < sizeof(HEAP_MB) / sizeof(HEAP_MB[0]); ++h) {
+		if (HEAP_MB[h] > grown) {
+			heap = (char *) malloc((HEAP_MB[h] - grown) << 20);
+			if (! heap)
+				break;
+			memset(heap, 1, (HEAP_MB[h] - grown) << 20); // fault it in
+			grown = HEAP_MB[h];
+		}
+
+		for (m = 0; m < sizeof(METHODS) / sizeof(METHODS[0]); ++m)
+			bench_method(&METHODS[m], grown, n);
+	}
+
+	zygote_stop();
+
+	return EXIT_SUCCESS;
+}
+
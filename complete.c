@@ -0,0 +1,677 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 08:03:17 AM
+ *
+ ***********************************************************************
+ */
+
+#include "complete.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <errno.h>
+
+/*
+ * Executables in PATH are kept in a prefix trie, so Tab costs a walk down
+ * the typed prefix however many binaries there are. The trie is built by
+ * a background thread, the first prompt does not wait for it and Tab
+ * answers from what is indexed so far. The thread then follows changes of
+ * PATH directories using inotify instead of rescanning them. Every name
+ * remembers which directories provide it, so it disappears only once the
+ * last of them loses it. Directories are read using getdents64 in large
+ * batches, the trie is locked only to insert a whole batch. A directory
+ * missing or gone keeps its slot and is looked for again every
+ * COMPLETE_RETRY_MS.
+ */
+
+/*
+ * Bit of builtins in trie_node_t.dirs, directories use the lower ones
+ */
+#define TRIE_BUILTIN			(1ULL << COMPLETE_MAX_DIRS)
+
+/*
+ * Size of a getdents64 batch
+ */
+#define COMPLETE_DENTS		32768
+
+/*
+ * Period of looking for PATH directories which do not exist
+ */
+#define COMPLETE_RETRY_MS	2000
+
+/*
+ * Events changing the set of executables in a directory
+ */
+#define COMPLETE_EVENTS		(IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO \
+									| IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+/**
+ * @brief  Directory entry as returned by getdents64
+ */
+struct dirent64_t {
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+struct trie_node_t;
+
+/**
+ * @brief  Edge of the trie
+ */
+struct trie_child_t {
+	unsigned char c;
+	struct trie_node_t * node;
+};
+
+/**
+ * @brief  Node of the trie, a name ends here if dirs is not 0
+ */
+struct trie_node_t {
+	uint64_t dirs;					// directories providing the name, TRIE_BUILTIN
+	unsigned int count;			// names in the subtree, this one included
+	unsigned int nchildren;
+	unsigned int cap;
+	struct trie_child_t * children;	// sorted by c
+};
+
+/**
+ * @brief  Indexed PATH directory
+ */
+struct complete_dir_t {
+	char * path;
+	int wd;							// inotify watch, -1 while missing
+};
+
+/*
+ * The trie, nodes are never freed while the shell runs, names only become
+ * dead (count 0); protected by complete_mutex
+ */
+static pthread_mutex_t complete_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct trie_node_t complete_root;
+
+/*
+ * Used by the index thread only once started
+ */
+static struct complete_dir_t complete_dirs[COMPLETE_MAX_DIRS];
+static int complete_ndirs = 0;
+static int complete_inotify = -1;
+
+static pthread_t complete_thread;
+static int complete_event = -1;
+static bool complete_exit = false;
+
+/**
+ * @brief  Read directory entries
+ *
+ * glibc got a getdents64 wrapper only recently, use the system call directly
+ *
+ * @param fd directory to read
+ * @param buf where to store entries
+ * @param len size of buf
+ *
+ * @return   number of bytes read, 0 at the end, -1 on failure
+ */
+static inline
+ssize_t sys_getdents64(int fd, void * buf, size_t len) {
+	return syscall(SYS_getdents64, fd, buf, len);
+}
+
+/**
+ * @brief  Find child of a node, optionally create it
+ *
+ * @param node node to use
+ * @param c character of the edge
+ * @param create create missing child
+ *
+ * @return   child or NULL if missing or out of memory
+ */
+static
+struct trie_node_t * trie_child(struct trie_node_t * node, unsigned char c, bool create) {
+	struct trie_child_t * children;
+	struct trie_node_t * child;
+	unsigned int lo = 0, hi = node->nchildren, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (node->children[mid].c == c)
+			return node->children[mid].node;
+		if (node->children[mid].c < c)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (! create)
+		return NULL;
+
+	if (node->nchildren == node->cap) {
+		children = (struct trie_child_t *) realloc(node->children,
+				(node->cap ? 2 * node->cap : 2) * sizeof(struct trie_child_t));
+		if (! children)
+			return NULL;
+		node->children = children;
+		node->cap = node->cap ? 2 * node->cap : 2;
+	}
+
+	if (! (child = (struct trie_node_t *) calloc(1, sizeof(struct trie_node_t))))
+		return NULL;
+
+	memmove(&node->children[lo + 1], &node->children[lo],
+			(node->nchildren - lo) * sizeof(struct trie_child_t));
+	node->children[lo].c = c;
+	node->children[lo].node = child;
+	node->nchildren++;
+
+	return child;
+}
+
+/**
+ * @brief  Set or clear a directory providing a name, complete_mutex held
+ *
+ * @param name name to use
+ * @param bit bit of the directory or TRIE_BUILTIN
+ * @param on true if the directory provides the name
+ */
+static
+void trie_set(const char * name, uint64_t bit, bool on) {
+	struct trie_node_t * path[COMPLETE_NAME_LEN + 1];
+	struct trie_node_t * node = &complete_root;
+	bool was;
+	int depth = 0;
+
+	path[depth++] = node;
+	for (; *name && node; ++name) {
+		if (depth > COMPLETE_NAME_LEN)
+			return; // too long to be completed anyway
+		node = trie_child(node, *name, on);
+		path[depth++] = node;
+	}
+
+	if (! node)
+		return;
+
+	was = node->dirs != 0;
+	node->dirs = on ? node->dirs | bit : node->dirs & ~bit;
+
+	if (was == (node->dirs != 0))
+		return;
+
+	while (depth-- > 0)
+		path[depth]->count += on ? 1 : -1;
+}
+
+/**
+ * @brief  Clear a directory from a subtree, complete_mutex held
+ *
+ * @param node subtree to use
+ * @param bit bit of the directory
+ */
+static
+void trie_clear(struct trie_node_t * node, uint64_t bit) {
+	node->dirs &= ~bit;
+	node->count = node->dirs != 0;
+
+	for (unsigned int i = 0; i < node->nchildren; ++i) {
+		trie_clear(node->children[i].node, bit);
+		node->count += node->children[i].node->count;
+	}
+}
+
+/**
+ * @brief  Collect names of a subtree in order, complete_mutex held
+ *
+ * @param node subtree to use
+ * @param name name of the node, extended in place
+ * @param len length of name
+ * @param res where to store names
+ */
+static
+void trie_list(const struct trie_node_t * node, char * name, size_t len,
+					struct complete_t * res) {
+	if (node->dirs) {
+		name[len] = '\0';
+		memcpy(res->list[res->nlist++], name, len + 1);
+	}
+
+	for (unsigned int i = 0; i < node->nchildren && res->nlist < COMPLETE_LIST; ++i) {
+		if (! node->children[i].node->count || len + 1 >= COMPLETE_NAME_LEN)
+			continue;
+		name[len] = node->children[i].c;
+		trie_list(node->children[i].node, name, len + 1, res);
+	}
+}
+
+/**
+ * @brief  Complete a command name
+ *
+ * @param prefix typed part of the name
+ * @param res where to store the result
+ */
+void complete_command(const char * prefix, struct complete_t * res) {
+	const struct trie_node_t * node = &complete_root;
+	const struct trie_node_t * next;
+	char name[COMPLETE_NAME_LEN];
+	size_t len = strlen(prefix);
+	unsigned int i;
+
+	res->count = res->nlist = 0;
+	res->dir = false;
+
+	if (len >= COMPLETE_NAME_LEN)
+		return;
+
+	pthread_mutex_lock(&complete_mutex);
+
+	for (i = 0; i < len && node; ++i)
+		node = trie_child((struct trie_node_t *) node, prefix[i], false);
+
+	if (node && node->count) {
+		res->count = node->count;
+		memcpy(name, prefix, len);
+
+		// extend while there is a single way on
+		while (! node->dirs && len + 1 < COMPLETE_NAME_LEN) {
+			for (i = 0, next = NULL; i < node->nchildren; ++i) {
+				if (node->children[i].node->count && next)
+					break;
+				if (node->children[i].node->count) {
+					next = node->children[i].node;
+					name[len] = node->children[i].c;
+				}
+			}
+			if (i < node->nchildren || ! next)
+				break;
+			node = next;
+			len++;
+		}
+
+		memcpy(res->common, name, len);
+		res->common[len] = '\0';
+
+		trie_list(node, name, len, res);
+	}
+
+	pthread_mutex_unlock(&complete_mutex);
+}
+
+/**
+ * @brief  Check if an entry of a directory is an executable file
+ *
+ * @param dfd directory to use
+ * @param name name of the entry
+ * @param type d_type of the entry
+ *
+ * @return   true if so
+ */
+static
+bool is_executable(int dfd, const char * name, unsigned char type) {
+	struct stat st;
+
+	if (type == DT_DIR)
+		return false;
+
+	// symlinks are followed
+	if (type != DT_REG && (fstatat(dfd, name, &st, 0) < 0 || ! S_ISREG(st.st_mode)))
+		return false;
+
+	return faccessat(dfd, name, X_OK, 0) == 0;
+}
+
+/**
+ * @brief  Index executables of a directory, called by the index thread
+ *
+ * @param d index of the directory
+ */
+static
+void index_scan(int d) {
+	static char buf[COMPLETE_DENTS];
+	static const char * names[COMPLETE_DENTS / sizeof(struct dirent64_t)];
+	struct dirent64_t * ent;
+	ssize_t len, off;
+	size_t n, i;
+	int fd;
+
+	// not kept open, IN_DELETE_SELF would not come until it is closed
+	if ((fd = open(complete_dirs[d].path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+		return;
+
+	while (! __atomic_load_n(&complete_exit, __ATOMIC_RELAXED)
+			&& (len = sys_getdents64(fd, buf, sizeof(buf))) > 0) {
+		// checked without the lock, Tab may come meanwhile
+		for (off = 0, n = 0; off < len; off += ent->d_reclen) {
+			ent = (struct dirent64_t *) (buf + off);
+			if (ent->d_name[0] != '.' && is_executable(fd, ent->d_name, ent->d_type))
+				names[n++] = ent->d_name;
+		}
+
+		pthread_mutex_lock(&complete_mutex);
+		for (i = 0; i < n; ++i)
+			trie_set(names[i], 1ULL << d, true);
+		pthread_mutex_unlock(&complete_mutex);
+	}
+
+	close(fd);
+}
+
+/**
+ * @brief  Watch and index a directory, called by the index thread
+ *
+ * @param d index of the directory
+ *
+ * @return   true if it exists
+ */
+static
+bool index_open(int d) {
+	struct complete_dir_t * dir = &complete_dirs[d];
+
+	// watched before reading, nothing can be missed
+	if ((dir->wd = inotify_add_watch(complete_inotify, dir->path, COMPLETE_EVENTS)) < 0)
+		return false;
+
+	index_scan(d);
+
+	return true;
+}
+
+/**
+ * @brief  Forget a directory which is gone, called by the index thread
+ *
+ * @param d index of the directory
+ */
+static
+void index_close(int d) {
+	struct complete_dir_t * dir = &complete_dirs[d];
+
+	pthread_mutex_lock(&complete_mutex);
+	trie_clear(&complete_root, 1ULL << d);
+	pthread_mutex_unlock(&complete_mutex);
+
+	inotify_rm_watch(complete_inotify, dir->wd);
+	dir->wd = -1;
+}
+
+/**
+ * @brief  Start indexing a PATH directory, called by the index thread
+ *
+ * @param path absolute path of the directory, it may not exist yet
+ */
+static
+void index_add(const char * path) {
+	struct complete_dir_t * dir = &complete_dirs[complete_ndirs];
+	int d;
+
+	for (d = 0; d < complete_ndirs; ++d)
+		if (! strcmp(complete_dirs[d].path, path))
+			return;
+
+	if (complete_ndirs == COMPLETE_MAX_DIRS || path[0] != '/')
+		return; // relative ones change meaning with the working directory
+
+	if (! (dir->path = strdup(path)))
+		return;
+	dir->wd = -1;
+
+	index_open(complete_ndirs++);
+}
+
+/**
+ * @brief  Apply inotify events, called by the index thread
+ *
+ * @param buf events read
+ * @param len length of events
+ */
+static
+void index_events(const char * buf, ssize_t len) {
+	const struct inotify_event * ev;
+	ssize_t off;
+	int d;
+
+	for (off = 0; off < len; off += sizeof(struct inotify_event) + ev->len) {
+		ev = (const struct inotify_event *) (buf + off);
+
+		if (ev->mask & IN_Q_OVERFLOW) { // events lost, read everything again
+			for (d = 0; d < complete_ndirs; ++d) {
+				if (complete_dirs[d].wd < 0)
+					continue;
+
+				// names removed meanwhile must not survive the rescan
+				pthread_mutex_lock(&complete_mutex);
+				trie_clear(&complete_root, 1ULL << d);
+				pthread_mutex_unlock(&complete_mutex);
+
+				index_scan(d);
+			}
+			continue;
+		}
+
+		for (d = 0; d < complete_ndirs && complete_dirs[d].wd != ev->wd; ++d)
+			;
+		if (d == complete_ndirs)
+			continue;
+
+		if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+			index_close(d); // see index_retry()
+			continue;
+		}
+
+		if (ev->len > 0 && ev->name[0] != '.') {
+			int fd = open(complete_dirs[d].path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			bool on = fd >= 0 && ! (ev->mask & (IN_DELETE | IN_MOVED_FROM))
+				&& is_executable(fd, ev->name, DT_UNKNOWN);
+
+			if (fd >= 0)
+				close(fd);
+
+			pthread_mutex_lock(&complete_mutex);
+			trie_set(ev->name, 1ULL << d, on);
+			pthread_mutex_unlock(&complete_mutex);
+		}
+	}
+}
+
+/**
+ * @brief  Look for directories which do not exist, called by the index thread
+ *
+ * @return   poll() timeout until the next try, -1 if none is missing
+ */
+static
+int index_retry() {
+	int timeout = -1;
+	int d;
+
+	for (d = 0; d < complete_ndirs; ++d)
+		if (complete_dirs[d].wd < 0 && ! index_open(d))
+			timeout = COMPLETE_RETRY_MS;
+
+	return timeout;
+}
+
+/**
+ * @brief  Index thread, builds the trie and keeps it up to date
+ *
+ * @param p PATH to index, freed here
+ *
+ * @return   NULL
+ */
+static
+void * index_run(void * p) {
+	char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	struct pollfd pfd[2];
+	char * path = (char *) p;
+	char * dir, * save;
+	ssize_t len;
+	int d;
+
+	for (dir = strtok_r(path, ":", &save); dir; dir = strtok_r(NULL, ":", &save))
+		index_add(dir);
+	free(path);
+
+	pfd[0].fd = complete_event;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = complete_inotify;
+	pfd[1].events = POLLIN;
+
+	while (! __atomic_load_n(&complete_exit, __ATOMIC_RELAXED)) {
+		if (poll(pfd, 2, index_retry()) < 0 && errno != EINTR)
+			break;
+
+		if (pfd[0].revents & POLLIN)
+			break; // complete_stop()
+
+		if ((pfd[1].revents & POLLIN)
+				&& (len = read(complete_inotify, buf, sizeof(buf))) > 0)
+			index_events(buf, len);
+	}
+
+	for (d = 0; d < complete_ndirs; ++d)
+		free(complete_dirs[d].path);
+	complete_ndirs = 0;
+
+	return NULL;
+}
+
+/**
+ * @brief  Start indexing PATH in background
+ *
+ * @param builtins NULL terminated names of builtins, completed as commands
+ *
+ * @return   true on success
+ */
+bool complete_start(const char * const * builtins) {
+	const char * env = getenv("PATH");
+	char * path;
+
+	pthread_mutex_lock(&complete_mutex);
+	for (; *builtins; ++builtins)
+		trie_set(*builtins, TRIE_BUILTIN, true);
+	pthread_mutex_unlock(&complete_mutex);
+
+	complete_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	complete_event = eventfd(0, EFD_CLOEXEC);
+	if (complete_inotify < 0 || complete_event < 0) {
+		perror("complete");
+		return false;
+	}
+
+	if (! (path = strdup(env ? env : ""))
+			|| pthread_create(&complete_thread, NULL, index_run, path) != 0) {
+		free(path);
+		close(complete_event);
+		complete_event = -1;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Stop indexing PATH
+ */
+void complete_stop() {
+	uint64_t one = 1;
+
+	if (complete_event < 0)
+		return;
+
+	__atomic_store_n(&complete_exit, true, __ATOMIC_RELAXED);
+	write(complete_event, &one, sizeof(one));
+	pthread_join(complete_thread, NULL);
+
+	close(complete_event);
+	close(complete_inotify);
+	complete_event = complete_inotify = -1;
+}
+
+/**
+ * @brief  Compare names for qsort()
+ */
+static
+int cmp_name(const void * a, const void * b) {
+	return strcmp((const char *) a, (const char *) b);
+}
+
+/**
+ * @brief  Complete a file name
+ *
+ * @param word typed part of the path
+ * @param res where to store the result
+ */
+void complete_file(const char * word, struct complete_t * res) {
+	char buf[COMPLETE_DENTS];
+	char dir[COMPLETE_NAME_LEN];
+	struct dirent64_t * ent;
+	const char * base;
+	const char * slash = strrchr(word, '/');
+	size_t dirlen = slash ? slash - word + 1 : 0;
+	size_t blen, clen = 0, i;
+	ssize_t len, off;
+	struct stat st;
+	int fd;
+
+	res->count = res->nlist = 0;
+	res->dir = false;
+
+	if (strlen(word) >= COMPLETE_NAME_LEN)
+		return;
+
+	base = word + dirlen;
+	blen = strlen(base);
+	memcpy(dir, word, dirlen);
+	dir[dirlen] = '\0';
+
+	if ((fd = open(dirlen ? dir : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+		return;
+
+	while ((len = sys_getdents64(fd, buf, sizeof(buf))) > 0) {
+		for (off = 0; off < len; off += ent->d_reclen) {
+			ent = (struct dirent64_t *) (buf + off);
+
+			if (strncmp(ent->d_name, base, blen)
+					|| (ent->d_name[0] == '.' && base[0] != '.')
+					|| ! strcmp(ent->d_name, ".") || ! strcmp(ent->d_name, ".."))
+				continue;
+
+			if (res->count++ == 0) {
+				clen = strlen(ent->d_name);
+				if (dirlen + clen >= COMPLETE_NAME_LEN)
+					clen = COMPLETE_NAME_LEN - dirlen - 1;
+				memcpy(res->common + dirlen, ent->d_name, clen);
+			} else {
+				for (i = 0; i < clen && res->common[dirlen + i] == ent->d_name[i]; ++i)
+					;
+				clen = i;
+			}
+
+			if (res->nlist < COMPLETE_LIST)
+				snprintf(res->list[res->nlist++], COMPLETE_NAME_LEN, "%s", ent->d_name);
+		}
+	}
+
+	memcpy(res->common, word, dirlen);
+	res->common[dirlen + clen] = '\0';
+
+	if (res->count == 1)
+		res->dir = fstatat(fd, res->common + dirlen, &st, 0) == 0 && S_ISDIR(st.st_mode);
+
+	close(fd);
+
+	qsort(res->list, res->nlist, COMPLETE_NAME_LEN, cmp_name);
+}
@@ -0,0 +1,47 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 07:58:31 AM
+ *
+ ***********************************************************************
+ */
+
+#ifndef COMPLETE_H_
+#define COMPLETE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Maximum length of a completed word
+ */
+#define COMPLETE_NAME_LEN		256
+
+/*
+ * Matches kept to be listed, the rest is only counted
+ */
+#define COMPLETE_LIST			64
+
+/*
+ * Maximum number of PATH directories indexed, one bit each in the index
+ */
+#define COMPLETE_MAX_DIRS		63
+
+/**
+ * @brief  Result of a completion
+ */
+struct complete_t {
+	size_t count;									// number of matches
+	size_t nlist;									// matches stored in list
+	bool dir;										// the only match is a directory
+	char common[COMPLETE_NAME_LEN];			// longest common prefix of matches
+	char list[COMPLETE_LIST][COMPLETE_NAME_LEN];
+};
+
+bool complete_start(const char * const * builtins);
+void complete_stop();
+void complete_command(const char * prefix, struct complete_t * res);
+void complete_file(const char * word, struct complete_t * res);
+
+#endif // COMPLETE_H_
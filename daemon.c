@@ -0,0 +1,1393 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 06:15:37 AM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/signalfd.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <errno.h>
+
+#include "daemon.h"
+#include "parse.h"
+#include "spawn.h"
+#include "pidfd.h"
+#include "fdpass.h"
+#include "deadline.h"
+#include "stats.h"
+
+/*
+ * The daemon serves many clients without starting a shell per command.
+ * Every connection has a reader thread which queues requests, a fixed pool
+ * of workers runs them: parse, spawn and wait as the executor does. Replies
+ * of requests of one connection may be written by several workers, they
+ * are serialized by a mutex of the connection. SIGINT and SIGTERM stop the
+ * daemon, requests still queued get an error, running ones are waited for.
+ *
+ * As an agent the same daemon listens on TCP. Descriptors cannot be passed
+ * there, so stdin of a command is a pipe fed by the reader from DAEMON_INPUT
+ * messages and its worker pumps stdout and stderr pipes to the client.
+ */
+
+static const char * MSG_LISTENING		= "\r<<< listening on %s, %d workers\n";
+static const char * MSG_STOPPED			= "\r<<< stopped, %lu requests served\n";
+
+static const char * ERR_IN_USE			= "daemon: %s is in use\n";
+static const char * ERR_PROTOCOL			= "daemon: protocol error, closing connection\n";
+static const char * ERR_ADDRESS			= "daemon: %s: %s\n";
+static const char * ERR_NO_TOKEN			= "daemon: agents require " DAEMON_TOKEN_ENV " to be set\n";
+
+/*
+ * Errors replied to clients
+ */
+static const char * ERR_REQ_MALFORMED	= "malformed request";
+static const char * ERR_REQ_PARSE		= "unable to parse command";
+static const char * ERR_REQ_BACKGROUND	= "background jobs are not supported";
+static const char * ERR_REQ_BUILTIN		= "builtins are not supported";
+static const char * ERR_REQ_PREFIX		= "invalid job prefix";
+static const char * ERR_REQ_EMPTY		= "empty command";
+static const char * ERR_REQ_REDIRECT	= "redirection failed";
+static const char * ERR_REQ_SPAWN		= "spawn failed";
+static const char * ERR_REQ_MEMORY		= "out of memory";
+static const char * ERR_REQ_STOPPING	= "daemon is stopping";
+static const char * ERR_REQ_GONE			= "client is gone";
+
+/*
+ * Size of DAEMON_OUTPUT messages
+ */
+#define DAEMON_CHUNK			65536
+
+/**
+ * @brief  Client connection
+ */
+struct daemon_conn_t {
+	int fd;
+	unsigned int refs;			// reader and requests, protected by daemon_mutex
+	bool authorized;				// sent the token, if any
+	bool closed;					// reader is done, protected by daemon_mutex
+	struct daemon_req_t * running;	// protected by daemon_mutex
+	pthread_mutex_t write_mutex;
+	struct daemon_conn_t * prev;
+	struct daemon_conn_t * next;
+};
+
+/**
+ * @brief  Received request
+ */
+struct daemon_req_t {
+	struct daemon_conn_t * conn;
+	uint32_t id;
+	char * data;					// payload, strings below point here
+	const char * cmd;
+	const char * cwd;				// NULL to inherit
+	char ** envp;					// NULL to inherit
+	int fds[3];						// stdin, stdout and stderr, -1 if not passed
+	bool stream;					// DAEMON_STREAM
+	int64_t received;
+	int pidfd;						// of running command, its PID may be reused once reaped
+	struct daemon_req_t * running_next;
+	struct daemon_req_t * next;
+};
+
+/**
+ * @brief  Write end of stdin of a streamed request, owned by the reader
+ */
+struct daemon_input_t {
+	uint32_t id;
+	int fd;							// non-blocking
+	char * buf;						// received, not taken by the pipe yet
+	size_t off;
+	size_t len;
+	size_t size;
+	bool eof;						// close once buf is written
+	struct daemon_input_t * next;
+};
+
+/*
+ * Queue of requests and connections, protected by daemon_mutex
+ */
+static pthread_mutex_t daemon_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t daemon_cond_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t daemon_cond_space = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t daemon_cond_conns = PTHREAD_COND_INITIALIZER;
+static struct daemon_req_t * queue_head = NULL;
+static struct daemon_req_t ** queue_tail = &queue_head;
+static unsigned int queue_length = 0;
+static struct daemon_conn_t * conns = NULL;
+static unsigned int nconns = 0;
+static bool daemon_exit = false;
+
+static int daemon_null = -1;
+static unsigned long daemon_served = 0;
+static bool daemon_tcp = false;
+static char * daemon_token = NULL;			// of agents, NULL if not required
+static const char * const * daemon_builtins = NULL;	// refused commands
+
+/**
+ * @brief  Release a reference to a connection, free it on the last one
+ *
+ * @param conn connection to release
+ */
+static
+void conn_unref(struct daemon_conn_t * conn) {
+	bool last;
+
+	pthread_mutex_lock(&daemon_mutex);
+	last = --conn->refs == 0;
+	if (last) {
+		if (conn->prev)
+			conn->prev->next = conn->next;
+		else
+			conns = conn->next;
+		if (conn->next)
+			conn->next->prev = conn->prev;
+		if (--nconns == 0)
+			pthread_cond_signal(&daemon_cond_conns);
+	}
+	pthread_mutex_unlock(&daemon_mutex);
+
+	if (last) {
+		close(conn->fd);
+		pthread_mutex_destroy(&conn->write_mutex);
+		free(conn);
+	}
+}
+
+/**
+ * @brief  Send a reply, a client gone meanwhile is not an error
+ *
+ * @param conn connection to use
+ * @param id id of the request
+ * @param type type of the reply
+ * @param flags flags of the reply
+ * @param payload data of the reply
+ * @param length length of data
+ */
+static
+void reply(struct daemon_conn_t * conn, uint32_t id, enum daemon_msg_t type,
+				uint32_t flags, const void * payload, size_t length) {
+	struct daemon_hdr_t hdr = { length, id, type, flags };
+	struct iovec iov[2] = {
+		{ &hdr, sizeof(hdr) },
+		{ (void *) payload, length },
+	};
+	struct iovec * it = iov;
+	struct msghdr msg;
+	int iovcnt = 2;
+	ssize_t ret;
+
+	memset(&msg, 0, sizeof(msg));
+
+	pthread_mutex_lock(&conn->write_mutex);
+	while (iovcnt > 0) {
+		msg.msg_iov = it;
+		msg.msg_iovlen = iovcnt;
+		ret = sendmsg(conn->fd, &msg, MSG_NOSIGNAL);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			break;
+
+		for (; iovcnt > 0 && (size_t) ret >= it->iov_len; ++it, --iovcnt)
+			ret -= it->iov_len;
+		if (iovcnt > 0) {
+			it->iov_base = (char *) it->iov_base + ret;
+			it->iov_len -= ret;
+		}
+	}
+	pthread_mutex_unlock(&conn->write_mutex);
+}
+
+/**
+ * @brief  Reply with an error
+ *
+ * @param req request to reply to
+ * @param msg error message
+ */
+static inline
+void reply_error(const struct daemon_req_t * req, const char * msg) {
+	reply(req->conn, req->id, DAEMON_ERROR, 0, msg, strlen(msg));
+}
+
+/**
+ * @brief  Free request, close descriptors not used and release connection
+ *
+ * @param req request to free
+ */
+static
+void req_free(struct daemon_req_t * req) {
+	for (int i = 0; i < 3; ++i)
+		if (req->fds[i] >= 0)
+			close(req->fds[i]);
+
+	conn_unref(req->conn);
+	free(req->envp);
+	free(req->data);
+	free(req);
+}
+
+/**
+ * @brief  Receive a request following its header
+ *
+ * @param conn connection to read from
+ * @param hdr received header
+ * @param fds descriptors received with the header
+ * @param nfds number of descriptors
+ *
+ * @return   request or NULL if the connection cannot be used any more
+ */
+static
+struct daemon_req_t * req_recv(struct daemon_conn_t * conn,
+				const struct daemon_hdr_t * hdr, int * fds, int nfds) {
+	struct daemon_req_t * req;
+	int none = 0;
+	int i, j;
+
+	req = (struct daemon_req_t *) calloc(1, sizeof(struct daemon_req_t));
+	if (! req || hdr->length > DAEMON_MAX_MSG
+			|| ! (req->data = (char *) malloc(hdr->length + 1))) {
+		while (nfds-- > 0)
+			close(fds[nfds]);
+		if (req)
+			free(req);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&daemon_mutex);
+	conn->refs++;
+	pthread_mutex_unlock(&daemon_mutex);
+
+	req->conn = conn;
+	req->id = hdr->id;
+	req->received = stats_now();
+
+	// passed descriptors in order of their flags
+	for (i = 0, j = 0; i < 3; ++i)
+		req->fds[i] = hdr->flags & (DAEMON_FD_IN << i) && j < nfds ? fds[j++] : -1;
+	while (j < nfds)
+		close(fds[j++]);
+
+	if (hdr->length > 0
+			&& ! fdpass_recv(conn->fd, req->data, hdr->length, NULL, &none)) {
+		req_free(req);
+		return NULL;
+	}
+	req->data[hdr->length] = '\0';
+
+	return req;
+}
+
+/**
+ * @brief  Unpack payload of a DAEMON_RUN request
+ *
+ * @param req request to unpack
+ * @param hdr header of the request
+ * @param nfds number of passed descriptors
+ *
+ * @return   true if the request is well formed
+ */
+static
+bool req_unpack(struct daemon_req_t * req, const struct daemon_hdr_t * hdr,
+					int nfds) {
+	char * end = req->data + hdr->length;
+	char * str;
+	size_t envc = 0;
+
+	req->stream = hdr->flags & DAEMON_STREAM;
+
+	if (hdr->length == 0 || end[-1] != '\0'
+			|| nfds != __builtin_popcount(hdr->flags
+					& (DAEMON_FD_IN | DAEMON_FD_OUT | DAEMON_FD_ERR))
+			|| (req->stream && nfds > 0))
+		return false;
+
+	req->cmd = req->data;
+	str = req->data + strlen(req->cmd) + 1;
+	if (str >= end || (*str && *str != '/'))
+		return false;
+
+	req->cwd = *str ? str : NULL;
+	str += strlen(str) + 1;
+
+	if (! (hdr->flags & DAEMON_ENV))
+		return true;
+
+	for (char * it = str; it < end; it += strlen(it) + 1)
+		++envc;
+
+	req->envp = (char **) malloc((envc + 1) * sizeof(char *));
+	if (! req->envp)
+		return false;
+
+	for (envc = 0; str < end; str += strlen(str) + 1)
+		req->envp[envc++] = str;
+	req->envp[envc] = (char *) 0;
+
+	return true;
+}
+
+/**
+ * @brief  Use passed descriptor for a stream not redirected
+ *
+ * @param req request to take the descriptor from
+ * @param i stream, 0 for stdin, 1 for stdout, 2 for stderr
+ * @param fd descriptor in spawn attributes
+ */
+static
+void req_take_fd(struct daemon_req_t * req, int i, int * fd) {
+	if (*fd != SPAWN_FD_INHERIT)
+		return;
+
+	if (req->fds[i] >= 0) {
+		*fd = req->fds[i];
+		req->fds[i] = -1;
+	} else {
+		*fd = fcntl(daemon_null, F_DUPFD_CLOEXEC, 0);
+	}
+}
+
+/**
+ * @brief  Is the command a builtin of the shell?
+ *
+ * @param name name of the command
+ *
+ * @return   true if so
+ */
+static
+bool is_builtin(const char * name) {
+	for (const char * const * it = daemon_builtins; it && *it; ++it)
+		if (! strcmp(*it, name))
+			return true;
+
+	return false;
+}
+
+/**
+ * @brief  Add or remove a running request of a connection, see DAEMON_KILL
+ *
+ * @param req request to add or remove
+ * @param running true to add
+ */
+static
+void req_running(struct daemon_req_t * req, bool running) {
+	struct daemon_req_t ** it;
+
+	pthread_mutex_lock(&daemon_mutex);
+	if (running) {
+		req->running_next = req->conn->running;
+		req->conn->running = req;
+	} else {
+		for (it = &req->conn->running; *it && *it != req; it = &(*it)->running_next)
+			;
+		if (*it)
+			*it = req->running_next;
+	}
+	pthread_mutex_unlock(&daemon_mutex);
+}
+
+/**
+ * @brief  Send stdout and stderr of a streamed request until both are closed
+ *
+ * @param req request to send output of
+ * @param out read end of stdout pipe, -1 if redirected
+ * @param err read end of stderr pipe, -1 if redirected
+ */
+static
+void req_pump(struct daemon_req_t * req, int out, int err) {
+	struct pollfd pfd[2] = {
+		{ .fd = out, .events = POLLIN },
+		{ .fd = err, .events = POLLIN },
+	};
+	char buf[DAEMON_CHUNK];
+	ssize_t len;
+	int i;
+
+	while (pfd[0].fd >= 0 || pfd[1].fd >= 0) {
+		if (poll(pfd, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		for (i = 0; i < 2; ++i) {
+			if (pfd[i].fd < 0 || ! pfd[i].revents)
+				continue;
+
+			len = read(pfd[i].fd, buf, sizeof(buf));
+			if (len < 0 && errno == EINTR)
+				continue;
+
+			if (len <= 0) {
+				close(pfd[i].fd);
+				pfd[i].fd = -1; // ignored by poll()
+				continue;
+			}
+
+			reply(req->conn, req->id, DAEMON_OUTPUT, i + 1, buf, len);
+		}
+	}
+
+	for (i = 0; i < 2; ++i)
+		if (pfd[i].fd >= 0)
+			close(pfd[i].fd);
+}
+
+/**
+ * @brief  Create pipe for stdout or stderr of a streamed request
+ *
+ * @param fd descriptor in spawn attributes, left alone if redirected
+ *
+ * @return   read end of the pipe, -1 if redirected or on failure
+ */
+static
+int req_pipe(int * fd) {
+	int p[2];
+
+	if (*fd != SPAWN_FD_INHERIT || pipe2(p, O_CLOEXEC) < 0)
+		return -1;
+
+	*fd = p[1];
+
+	return p[0];
+}
+
+/**
+ * @brief  Run a request and reply, called by a worker
+ *
+ * @param req request to run
+ */
+static
+void req_run(struct daemon_req_t * req) {
+	struct daemon_started_t started;
+	struct daemon_exited_t exited;
+	struct parse_list_t cmd_list;
+	struct parse_litem_t * it;
+	struct spawn_attr_t attr;
+	struct rusage ru;
+	char ** argv = NULL;
+	char ** args;
+	int64_t start = stats_now();
+	int64_t spawned;
+	int out = -1;
+	int err = -1;
+	size_t i;
+	pid_t pid;
+
+	stats_record(STATS_HANDOFF, start - req->received);
+
+	memset(&exited, 0, sizeof(exited));
+	memset(&ru, 0, sizeof(ru)); // zero if waiting fails
+	exited.queued_ns = start - req->received;
+
+	spawn_attr_init(&attr);
+	parse_list_init(&cmd_list);
+
+	if (! parse_command(&cmd_list, req->cmd)) {
+		reply_error(req, ERR_REQ_PARSE);
+		goto cleanup;
+	}
+	stats_record(STATS_PARSE, stats_now() - start);
+
+	if (cmd_list.background) {
+		reply_error(req, ERR_REQ_BACKGROUND);
+		goto cleanup;
+	}
+
+	argv = (char **) malloc((cmd_list.length + 1) * sizeof(char *));
+	if (! argv) {
+		reply_error(req, ERR_REQ_MEMORY);
+		goto cleanup;
+	}
+
+	for (it = cmd_list.head, i = 0; it; it = it->next, ++i)
+		argv[i] = it->token;
+	argv[cmd_list.length] = (char *) 0;
+
+	attr.cwd = req->cwd;
+	attr.envp = req->envp;
+	attr.timeout_ms = deadline_default();
+
+	if (! (args = spawn_attr_prefix(&attr, argv))) {
+		reply_error(req, ERR_REQ_PREFIX);
+		goto cleanup;
+	}
+
+	if (! args[0]) {
+		reply_error(req, ERR_REQ_EMPTY);
+		goto cleanup;
+	}
+
+	// they would be looked up in PATH
+	if (is_builtin(args[0])) {
+		reply_error(req, ERR_REQ_BUILTIN);
+		goto cleanup;
+	}
+
+	if (! spawn_attr_open(&attr, &cmd_list)) {
+		reply_error(req, ERR_REQ_REDIRECT);
+		goto cleanup;
+	}
+
+	if (req->stream) {
+		out = req_pipe(&attr.fd_out);
+		err = req_pipe(&attr.fd_err);
+	}
+
+	req_take_fd(req, 0, &attr.fd_in);
+	req_take_fd(req, 1, &attr.fd_out);
+	req_take_fd(req, 2, &attr.fd_err);
+
+	stats_count(STATS_COMMANDS);
+
+	spawned = stats_now();
+	pid = spawn_command(args, &attr);
+	exited.spawn_ns = stats_now() - spawned;
+
+	// child has its copies, the client sees end of file once it exits
+	spawn_attr_close(&attr);
+
+	if (pid < 0) {
+		reply_error(req, ERR_REQ_SPAWN);
+		goto cleanup;
+	}
+
+	// not reaped yet, so it is the child
+	req->pidfd = sys_pidfd_open(pid);
+	req_running(req, true);
+
+	started.pid = pid;
+	reply(req->conn, req->id, DAEMON_STARTED, 0, &started, sizeof(started));
+
+	if (req->stream) {
+		req_pump(req, out, err);
+		out = err = -1;
+	}
+
+	exited.pid = pid;
+	exited.status = spawn_wait_rusage(pid, &ru);
+	req_running(req, false);
+	if (req->pidfd >= 0)
+		close(req->pidfd);
+	exited.run_ns = stats_now() - spawned - exited.spawn_ns;
+	exited.utime_us = ru.ru_utime.tv_sec * 1000000LL + ru.ru_utime.tv_usec;
+	exited.stime_us = ru.ru_stime.tv_sec * 1000000LL + ru.ru_stime.tv_usec;
+	exited.maxrss_kb = ru.ru_maxrss;
+
+	reply(req->conn, req->id, DAEMON_EXITED, 0, &exited, sizeof(exited));
+	__atomic_add_fetch(&daemon_served, 1, __ATOMIC_RELAXED);
+
+cleanup:
+	if (out >= 0)
+		close(out);
+	if (err >= 0)
+		close(err);
+	spawn_attr_close(&attr);
+	parse_free(&cmd_list);
+	free(argv);
+}
+
+/**
+ * @brief  Worker, runs queued requests until the daemon stops
+ *
+ * @param p unused
+ *
+ * @return   NULL
+ */
+static
+void * daemon_work(void * p) {
+	struct daemon_req_t * req;
+	bool stopping, gone;
+
+	(void) p;
+
+	for (;;) {
+		pthread_mutex_lock(&daemon_mutex);
+		while (! queue_head && ! daemon_exit)
+			pthread_cond_wait(&daemon_cond_work, &daemon_mutex);
+
+		if ((req = queue_head)) {
+			if (! (queue_head = req->next))
+				queue_tail = &queue_head;
+			queue_length--;
+			pthread_cond_signal(&daemon_cond_space);
+		}
+		stopping = daemon_exit;
+		gone = req && req->stream && req->conn->closed;
+		pthread_mutex_unlock(&daemon_mutex);
+
+		if (! req)
+			break;
+
+		if (stopping)
+			reply_error(req, ERR_REQ_STOPPING);
+		else if (gone) // nobody to send output to
+			reply_error(req, ERR_REQ_GONE);
+		else
+			req_run(req);
+
+		req_free(req);
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief  Create stdin pipe of a streamed request
+ *
+ * @param inputs write ends of the reader
+ * @param req request to create pipe for
+ *
+ * @return   true on success
+ */
+static
+bool input_open(struct daemon_input_t ** inputs, struct daemon_req_t * req) {
+	struct daemon_input_t * input;
+	int p[2];
+
+	input = (struct daemon_input_t *) calloc(1, sizeof(struct daemon_input_t));
+	if (! input || pipe2(p, O_CLOEXEC) < 0) {
+		free(input);
+		return false;
+	}
+
+	// the reader must not wait for a command, see conn_wait()
+	fcntl(p[1], F_SETFL, O_NONBLOCK);
+
+	req->fds[0] = p[0];
+	input->id = req->id;
+	input->fd = p[1];
+	input->next = *inputs;
+	*inputs = input;
+
+	return true;
+}
+
+/**
+ * @brief  Close stdin pipe of a streamed request
+ *
+ * @param link pointer to the input in the list of the reader
+ */
+static
+void input_close(struct daemon_input_t ** link) {
+	struct daemon_input_t * input = *link;
+
+	close(input->fd);
+	*link = input->next;
+	free(input->buf);
+	free(input);
+}
+
+/**
+ * @brief  Write buffered stdin of a streamed request as far as the pipe takes it
+ *
+ * @param input input to write
+ *
+ * @return   false if it is to be closed, i.e. it ended or the command does not
+ *           read any more
+ */
+static
+bool input_flush(struct daemon_input_t * input) {
+	ssize_t ret;
+
+	while (input->off < input->len) {
+		ret = write(input->fd, input->buf + input->off, input->len - input->off);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0 && errno == EAGAIN)
+			return true;
+		if (ret < 0)
+			return false; // drop the rest
+		input->off += ret;
+	}
+
+	input->off = input->len = 0;
+
+	return ! input->eof;
+}
+
+/**
+ * @brief  Feed stdin of a streamed request, close it on empty data
+ *
+ * Data the pipe does not take is buffered and written once the command reads,
+ * see conn_wait().
+ *
+ * @param inputs write ends of the reader
+ * @param id id of the request
+ * @param data data to write
+ * @param len length of data
+ */
+static
+void input_write(struct daemon_input_t ** inputs, uint32_t id,
+						const char * data, size_t len) {
+	struct daemon_input_t * input;
+	size_t size;
+	char * buf;
+
+	for (; *inputs && (*inputs)->id != id; inputs = &(*inputs)->next)
+		;
+	if (! (input = *inputs))
+		return;
+
+	if (len == 0)
+		input->eof = true;
+
+	if (input->len + len > input->size && input->off > 0) {
+		memmove(input->buf, input->buf + input->off, input->len - input->off);
+		input->len -= input->off;
+		input->off = 0;
+	}
+
+	if (input->len + len > input->size) {
+		size = input->size ? input->size : DAEMON_CHUNK;
+		while (size < input->len + len)
+			size *= 2;
+		if (! (buf = (char *) realloc(input->buf, size))) {
+			input_close(inputs); // out of memory, the command gets end of file
+			return;
+		}
+		input->buf = buf;
+		input->size = size;
+	}
+
+	memcpy(input->buf + input->len, data, len);
+	input->len += len;
+
+	if (! input_flush(input))
+		input_close(inputs);
+}
+
+/**
+ * @brief  Compare a received token in constant time
+ *
+ * Time depends only on the length of the expected token, so it does not
+ * tell how many leading bytes of a guess were right.
+ *
+ * @param data received token
+ * @param len length of data
+ * @param token expected token
+ *
+ * @return   true if they are equal
+ */
+static
+bool token_equal(const char * data, size_t len, const char * token) {
+	size_t tlen = strlen(token);
+	unsigned char diff = len != tlen;
+
+	for (size_t i = 0; i < tlen; ++i)
+		diff |= (unsigned char) token[i] ^ (unsigned char) (i < len ? data[i] : 0);
+
+	return diff == 0;
+}
+
+/**
+ * @brief  Handle a message other than DAEMON_RUN
+ *
+ * @param conn connection the message came from
+ * @param hdr header of the message
+ * @param inputs write ends of the reader
+ *
+ * @return   false if the connection cannot be used any more
+ */
+static
+bool conn_control(struct daemon_conn_t * conn, const struct daemon_hdr_t * hdr,
+						struct daemon_input_t ** inputs) {
+	struct daemon_req_t * req;
+	char * data;
+	int none = 0;
+	bool ok = true;
+
+	if (hdr->length > DAEMON_MAX_MSG
+			|| ! (data = (char *) malloc(hdr->length + 1)))
+		return false;
+
+	if (hdr->length > 0
+			&& ! fdpass_recv(conn->fd, data, hdr->length, NULL, &none)) {
+		free(data);
+		return false;
+	}
+
+	switch (hdr->type) {
+		case DAEMON_HELLO:
+			conn->authorized = ! daemon_token
+				|| token_equal(data, hdr->length, daemon_token);
+			ok = conn->authorized;
+			break;
+
+		case DAEMON_INPUT:
+			input_write(inputs, hdr->id, data, hdr->length);
+			break;
+
+		case DAEMON_KILL:
+			pthread_mutex_lock(&daemon_mutex);
+			for (req = conn->running; req && req->id != hdr->id; req = req->running_next)
+				;
+			if (req && req->pidfd >= 0)
+				sys_pidfd_send_signal(req->pidfd, hdr->flags);
+			pthread_mutex_unlock(&daemon_mutex);
+			break;
+
+		default:
+			ok = false;
+	}
+
+	free(data);
+
+	return ok;
+}
+
+/**
+ * @brief  Reader of a connection is done, streamed commands are terminated
+ *
+ * @param conn connection closed
+ * @param inputs write ends of the reader, closed
+ */
+static
+void conn_close(struct daemon_conn_t * conn, struct daemon_input_t * inputs) {
+	struct daemon_req_t * req;
+
+	while (inputs)
+		input_close(&inputs);
+
+	pthread_mutex_lock(&daemon_mutex);
+	conn->closed = true;
+	for (req = conn->running; req; req = req->running_next)
+		if (req->stream && req->pidfd >= 0)
+			sys_pidfd_send_signal(req->pidfd, SIGTERM);
+	pthread_mutex_unlock(&daemon_mutex);
+}
+
+/**
+ * @brief  Write buffered stdin of streamed requests until a message comes
+ *
+ * The connection is read even if commands do not read their stdin, so that
+ * DAEMON_KILL gets through. Only a request having more than DAEMON_MAX_INPUT
+ * bytes buffered stops it until the command catches up.
+ *
+ * @param conn connection to wait for
+ * @param inputs write ends of the reader
+ * @param pfd array of the reader for poll(), grown as needed
+ * @param npfd size of pfd
+ *
+ * @return   false on failure
+ */
+static
+bool conn_wait(struct daemon_conn_t * conn, struct daemon_input_t ** inputs,
+					struct pollfd ** pfd, size_t * npfd) {
+	struct daemon_input_t ** link;
+	struct pollfd * grown;
+	bool full;
+	size_t n;
+
+	for (;;) {
+		full = false;
+		n = 1;
+		for (link = inputs; *link; link = &(*link)->next) {
+			if ((*link)->off == (*link)->len)
+				continue;
+			full |= (*link)->len - (*link)->off > DAEMON_MAX_INPUT;
+
+			if (n >= *npfd) {
+				grown = (struct pollfd *) realloc(*pfd, 4 * n * sizeof(struct pollfd));
+				if (! grown)
+					return false;
+				*pfd = grown;
+				*npfd = 4 * n;
+			}
+			(*pfd)[n].fd = (*link)->fd;
+			(*pfd)[n].events = POLLOUT;
+			n++;
+		}
+
+		if (n == 1) // nothing to write, wait in fdpass_recv()
+			return true;
+
+		(*pfd)[0].fd = conn->fd;
+		(*pfd)[0].events = full ? 0 : POLLIN;
+
+		if (poll(*pfd, n, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+
+		// same order as above, the list did not change meanwhile
+		n = 1;
+		for (link = inputs; *link; ) {
+			if ((*link)->off == (*link)->len) {
+				link = &(*link)->next;
+				continue;
+			}
+			if ((*pfd)[n++].revents && ! input_flush(*link)) {
+				input_close(link);
+				continue;
+			}
+			link = &(*link)->next;
+		}
+
+		if ((*pfd)[0].revents)
+			return true;
+	}
+}
+
+/**
+ * @brief  Reader of a connection, queues received requests
+ *
+ * @param p connection to read from
+ *
+ * @return   NULL
+ */
+static
+void * conn_read(void * p) {
+	struct daemon_conn_t * conn = (struct daemon_conn_t *) p;
+	struct daemon_input_t * inputs = NULL;
+	struct pollfd * pfd = NULL;
+	struct daemon_hdr_t hdr;
+	struct daemon_req_t * req;
+	size_t npfd = 0;
+	sigset_t setpipe;
+	int fds[FDPASS_MAX];
+	int nfds;
+
+	// a command not reading its stdin is not fatal, see input_write()
+	sigemptyset(&setpipe);
+	sigaddset(&setpipe, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &setpipe, NULL);
+
+	for (;;) {
+		if (! conn_wait(conn, &inputs, &pfd, &npfd))
+			break;
+
+		nfds = FDPASS_MAX;
+		if (! fdpass_recv(conn->fd, &hdr, sizeof(hdr), fds, &nfds))
+			break; // client is done
+
+		if (hdr.type != DAEMON_RUN || ! conn->authorized) {
+			while (nfds-- > 0)
+				close(fds[nfds]);
+			if ((hdr.type == DAEMON_HELLO || conn->authorized)
+					&& conn_control(conn, &hdr, &inputs))
+				continue;
+			write(2, ERR_PROTOCOL, strlen(ERR_PROTOCOL));
+			break;
+		}
+
+		if (! (req = req_recv(conn, &hdr, fds, nfds))) {
+			write(2, ERR_PROTOCOL, strlen(ERR_PROTOCOL));
+			break;
+		}
+
+		if (! req_unpack(req, &hdr, nfds)) {
+			reply_error(req, ERR_REQ_MALFORMED);
+			req_free(req);
+			continue;
+		}
+
+		if (req->stream && ! input_open(&inputs, req)) {
+			reply_error(req, ERR_REQ_MEMORY);
+			req_free(req);
+			continue;
+		}
+
+		pthread_mutex_lock(&daemon_mutex);
+		while (queue_length >= DAEMON_MAX_QUEUE && ! daemon_exit)
+			pthread_cond_wait(&daemon_cond_space, &daemon_mutex);
+
+		if (! daemon_exit) {
+			*queue_tail = req;
+			queue_tail = &req->next;
+			queue_length++;
+			pthread_cond_signal(&daemon_cond_work);
+			req = NULL;
+		}
+		pthread_mutex_unlock(&daemon_mutex);
+
+		if (req) {
+			reply_error(req, ERR_REQ_STOPPING);
+			req_free(req);
+		}
+	}
+
+	conn_close(conn, inputs);
+	conn_unref(conn);
+	free(pfd);
+
+	return NULL;
+}
+
+/**
+ * @brief  Accept a client and start its reader
+ *
+ * @param sock listening socket
+ */
+static
+void conn_accept(int sock) {
+	struct daemon_conn_t * conn;
+	pthread_attr_t tattr;
+	pthread_t reader;
+	int one = 1;
+	int fd;
+
+	if ((fd = accept4(sock, NULL, NULL, SOCK_CLOEXEC)) < 0)
+		return;
+
+	conn = (struct daemon_conn_t *) malloc(sizeof(struct daemon_conn_t));
+	if (! conn) {
+		close(fd);
+		return;
+	}
+
+	if (daemon_tcp) // replies are small and latency matters
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	conn->fd = fd;
+	conn->refs = 1; // reader
+	conn->authorized = ! daemon_token;
+	conn->closed = false;
+	conn->running = NULL;
+	conn->prev = NULL;
+	pthread_mutex_init(&conn->write_mutex, NULL);
+
+	pthread_mutex_lock(&daemon_mutex);
+	if ((conn->next = conns))
+		conns->prev = conn;
+	conns = conn;
+	nconns++;
+	pthread_mutex_unlock(&daemon_mutex);
+
+	pthread_attr_init(&tattr);
+	pthread_attr_setdetachstate(&tattr, PTHREAD_CREATE_DETACHED);
+	if (pthread_create(&reader, &tattr, conn_read, conn) != 0)
+		conn_unref(conn);
+	pthread_attr_destroy(&tattr);
+}
+
+/**
+ * @brief  Is there a socket nobody listens on?
+ *
+ * @param addr address of the socket
+ *
+ * @return   true if the socket file is left over by a daemon gone
+ */
+static
+bool socket_stale(const struct sockaddr_un * addr) {
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	bool stale;
+
+	stale = fd >= 0 && connect(fd, (const struct sockaddr *) addr, sizeof(*addr)) < 0
+		&& errno == ECONNREFUSED;
+
+	if (fd >= 0)
+		close(fd);
+
+	return stale;
+}
+
+/**
+ * @brief  Create listening socket, accessible by the owner only
+ *
+ * @param path path of the socket
+ *
+ * @return   socket or -1 on failure (error is reported)
+ */
+static
+int daemon_listen(const char * path) {
+	struct sockaddr_un addr;
+	bool in_use;
+	int fd;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		errno = ENAMETOOLONG;
+		perror(path);
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+
+	if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+		perror("socket");
+		return -1;
+	}
+
+	if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		in_use = errno == EADDRINUSE;
+		if (in_use && ! socket_stale(&addr)) {
+			fprintf(stderr, ERR_IN_USE, path);
+			close(fd);
+			return -1;
+		}
+
+		if (! in_use || unlink(path) < 0
+				|| bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+			perror(path);
+			close(fd);
+			return -1;
+		}
+	}
+
+	// nobody can connect before listen()
+	if (chmod(path, S_IRUSR | S_IWUSR) < 0 || listen(fd, SOMAXCONN) < 0) {
+		perror(path);
+		close(fd);
+		unlink(path);
+		return -1;
+	}
+
+	return fd;
+}
+
+/**
+ * @brief  Resolve address of an agent
+ *
+ * @param addr [HOST:]PORT, HOST defaults to DAEMON_TCP_HOST
+ * @param passive true to listen on the address
+ *
+ * @return   addresses to be freed using freeaddrinfo() or NULL (error is
+ *           reported)
+ */
+struct addrinfo * daemon_resolve(const char * addr, bool passive) {
+	struct addrinfo hints;
+	struct addrinfo * res;
+	const char * port = strrchr(addr, ':');
+	char host[256];
+	int ret;
+
+	if (! port) {
+		snprintf(host, sizeof(host), "%s", DAEMON_TCP_HOST);
+		port = addr;
+	} else {
+		snprintf(host, sizeof(host), "%.*s", (int) (port - addr), addr);
+		port++;
+	}
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+	if ((ret = getaddrinfo(host, port, &hints, &res)) != 0) {
+		fprintf(stderr, ERR_ADDRESS, addr, gai_strerror(ret));
+		return NULL;
+	}
+
+	return res;
+}
+
+/**
+ * @brief  Create listening TCP socket
+ *
+ * @param addr [HOST:]PORT to listen on
+ *
+ * @return   socket or -1 on failure (error is reported)
+ */
+static
+int daemon_listen_tcp(const char * addr) {
+	struct addrinfo * res, * it;
+	int one = 1;
+	int fd = -1;
+
+	if (! (res = daemon_resolve(addr, true)))
+		return -1;
+
+	for (it = res; it; it = it->ai_next) {
+		fd = socket(it->ai_family, it->ai_socktype | SOCK_CLOEXEC, it->ai_protocol);
+		if (fd < 0)
+			continue;
+
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		if (bind(fd, it->ai_addr, it->ai_addrlen) == 0 && listen(fd, SOMAXCONN) == 0)
+			break;
+
+		close(fd);
+		fd = -1;
+	}
+
+	if (fd < 0)
+		fprintf(stderr, ERR_ADDRESS, addr, strerror(errno));
+
+	freeaddrinfo(res);
+
+	return fd;
+}
+
+/**
+ * @brief  Serve commands until SIGINT or SIGTERM
+ *
+ * SIGCHLD, SIGINT and SIGTERM have to be blocked in all threads.
+ *
+ * @param sock listening socket, closed on return
+ * @param name address of the socket, reported only
+ * @param workers number of requests run in parallel
+ * @param builtins NULL terminated names of builtins, refused
+ *
+ * @return   true on success
+ */
+static
+bool daemon_serve(int sock, const char * name, int workers,
+						const char * const * builtins) {
+	struct daemon_conn_t * conn;
+	struct pollfd pfd[2];
+	pthread_t * threads;
+	sigset_t setstop;
+	int started = 0;
+	int sfd;
+	bool ok;
+
+	daemon_builtins = builtins;
+
+	sigemptyset(&setstop);
+	sigaddset(&setstop, SIGINT);
+	sigaddset(&setstop, SIGTERM);
+
+	if ((sfd = signalfd(-1, &setstop, SFD_CLOEXEC)) < 0) {
+		perror("signalfd");
+		close(sock);
+		return false;
+	}
+
+	if ((daemon_null = open("/dev/null", O_RDWR | O_CLOEXEC)) < 0) {
+		perror("/dev/null");
+		close(sfd);
+		close(sock);
+		return false;
+	}
+
+	threads = (pthread_t *) malloc(workers * sizeof(pthread_t));
+	for (; threads && started < workers; ++started)
+		if (pthread_create(&threads[started], NULL, daemon_work, NULL) != 0)
+			break;
+
+	if ((ok = started > 0))
+		fprintf(stderr, MSG_LISTENING, name, started);
+	else
+		perror("pthread_create");
+
+	pfd[0].fd = sfd;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = sock;
+	pfd[1].events = POLLIN;
+
+	while (ok) {
+		if (poll(pfd, 2, -1) < 0 && errno != EINTR)
+			break;
+
+		if (pfd[0].revents & POLLIN)
+			break; // not read, nobody else waits for it
+
+		if (pfd[1].revents & POLLIN)
+			conn_accept(sock);
+	}
+
+	close(sock);
+
+	// readers get end of file, queued requests are refused
+	pthread_mutex_lock(&daemon_mutex);
+	daemon_exit = true;
+	for (conn = conns; conn; conn = conn->next)
+		shutdown(conn->fd, SHUT_RD);
+	pthread_cond_broadcast(&daemon_cond_work);
+	pthread_cond_broadcast(&daemon_cond_space);
+	pthread_mutex_unlock(&daemon_mutex);
+
+	while (started-- > 0)
+		pthread_join(threads[started], NULL);
+
+	pthread_mutex_lock(&daemon_mutex);
+	while (nconns > 0)
+		pthread_cond_wait(&daemon_cond_conns, &daemon_mutex);
+	pthread_mutex_unlock(&daemon_mutex);
+
+	if (ok)
+		fprintf(stderr, MSG_STOPPED, daemon_served);
+
+	free(threads);
+	close(daemon_null);
+	close(sfd);
+
+	return ok;
+}
+
+/**
+ * @brief  Serve commands on a Unix socket until SIGINT or SIGTERM
+ *
+ * Called instead of the interactive loop; SIGCHLD, SIGINT and SIGTERM have
+ * to be blocked in all threads.
+ *
+ * @param path path of the socket
+ * @param workers number of requests run in parallel
+ * @param builtins NULL terminated names of builtins, refused
+ *
+ * @return   true on success
+ */
+bool daemon_run(const char * path, int workers, const char * const * builtins) {
+	int sock;
+	bool ok;
+
+	if ((sock = daemon_listen(path)) < 0)
+		return false;
+
+	ok = daemon_serve(sock, path, workers, builtins);
+	unlink(path);
+
+	return ok;
+}
+
+/**
+ * @brief  Serve commands as an agent on TCP until SIGINT or SIGTERM
+ *
+ * Like daemon_run(), but DAEMON_TOKEN_ENV has to be set and clients have to
+ * send it first. It is removed from the environment, commands do not get it.
+ *
+ * @param addr [HOST:]PORT to listen on
+ * @param workers number of requests run in parallel
+ * @param builtins NULL terminated names of builtins, refused
+ *
+ * @return   true on success
+ */
+bool daemon_run_tcp(const char * addr, int workers, const char * const * builtins) {
+	const char * token = getenv(DAEMON_TOKEN_ENV);
+	int sock;
+	bool ok;
+
+	// anybody able to connect could run commands as our user
+	if (! token || ! *token) {
+		write(2, ERR_NO_TOKEN, strlen(ERR_NO_TOKEN));
+		return false;
+	}
+
+	if (! (daemon_token = strdup(token)))
+		return false;
+	unsetenv(DAEMON_TOKEN_ENV); // environment of commands is ours
+
+	if ((sock = daemon_listen_tcp(addr)) < 0) {
+		free(daemon_token);
+		return false;
+	}
+
+	daemon_tcp = true;
+	ok = daemon_serve(sock, addr, workers, builtins);
+
+	free(daemon_token);
+	daemon_token = NULL;
+
+	return ok;
+}
+
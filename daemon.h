@@ -0,0 +1,146 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 06:14:52 AM
+ *
+ ***********************************************************************
+ */
+
+#ifndef DAEMON_H_
+#define DAEMON_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Protocol of proj3 -d SOCKET, a Unix stream socket. Every message is
+ * a struct daemon_hdr_t followed by length bytes of payload, integers are
+ * in host byte order. A client may have any number of requests in flight,
+ * replies carry the id of their request and come in order of completion.
+ *
+ * DAEMON_RUN request payload is NUL terminated strings: the command line
+ * (as typed at the prompt, job prefixes and redirections included), the
+ * absolute working directory (empty to keep the one of the daemon) and, if
+ * DAEMON_ENV is set, the environment as NAME=value strings. Descriptors for
+ * stdin, stdout and stderr selected by DAEMON_FD_* flags are passed using
+ * SCM_RIGHTS with the header, i.e. with the first byte of the message.
+ * Redirections in the command line take precedence, streams not passed
+ * nor redirected are /dev/null.
+ *
+ * The request is answered by DAEMON_STARTED and DAEMON_EXITED, or by
+ * a DAEMON_ERROR with a message if the command could not be run.
+ *
+ * With DAEMON_STREAM, used over TCP where descriptors cannot be passed,
+ * stdin is sent by the client in DAEMON_INPUT messages (an empty one ends
+ * it) and stdout and stderr come back in DAEMON_OUTPUT messages before
+ * DAEMON_EXITED. Such commands are sent SIGTERM if the client disconnects.
+ * DAEMON_KILL sends the signal number in flags to a running command.
+ *
+ * An agent (proj3 -a) refuses to start without DAEMON_TOKEN_ENV set in its
+ * environment and closes connections not starting with DAEMON_HELLO carrying
+ * the token. The token is sent in clear text, use a tunnel (e.g. ssh or a VPN)
+ * on untrusted networks. Both ends have to have the same byte order.
+ */
+
+/*
+ * Default address an agent listens on if only a port is given
+ */
+#define DAEMON_TCP_HOST		"127.0.0.1"
+
+/*
+ * Environment variable holding the shared secret of agents
+ */
+#define DAEMON_TOKEN_ENV		"PROJ3_AGENT_TOKEN"
+
+/*
+ * Number of requests run in parallel
+ */
+#ifndef DAEMON_WORKERS
+# define DAEMON_WORKERS		16
+#endif // DAEMON_WORKERS
+
+/*
+ * Requests received but not picked up by a worker yet, reading from clients
+ * stops when full
+ */
+#ifndef DAEMON_MAX_QUEUE
+# define DAEMON_MAX_QUEUE	1024
+#endif // DAEMON_MAX_QUEUE
+
+/*
+ * Stdin of a streamed request buffered while the command does not read it,
+ * reading from the client stops when over
+ */
+#ifndef DAEMON_MAX_INPUT
+# define DAEMON_MAX_INPUT	(16 << 20)
+#endif // DAEMON_MAX_INPUT
+
+/*
+ * Maximum payload of a message
+ */
+#define DAEMON_MAX_MSG		(1 << 20)
+
+/**
+ * @brief  Message types
+ */
+enum daemon_msg_t {
+	DAEMON_RUN = 1,		// request to run a command
+	DAEMON_STARTED,		// struct daemon_started_t
+	DAEMON_EXITED,			// struct daemon_exited_t
+	DAEMON_ERROR,			// error message, not NUL terminated
+	DAEMON_HELLO,			// token
+	DAEMON_INPUT,			// stdin data, empty at end of file
+	DAEMON_OUTPUT,			// flags 1 for stdout or 2 for stderr data
+	DAEMON_KILL,			// flags signal number, no payload
+};
+
+/*
+ * Flags of DAEMON_RUN
+ */
+#define DAEMON_FD_IN			(1 << 0)
+#define DAEMON_FD_OUT		(1 << 1)
+#define DAEMON_FD_ERR		(1 << 2)
+#define DAEMON_ENV			(1 << 3)
+#define DAEMON_STREAM		(1 << 4)
+
+/**
+ * @brief  Message header
+ */
+struct daemon_hdr_t {
+	uint32_t length;		// of payload following the header
+	uint32_t id;			// chosen by the client, echoed in replies
+	uint32_t type;			// enum daemon_msg_t
+	uint32_t flags;		// DAEMON_FD_*, DAEMON_ENV
+};
+
+/**
+ * @brief  Command was spawned
+ */
+struct daemon_started_t {
+	int32_t pid;
+};
+
+/**
+ * @brief  Command exited
+ */
+struct daemon_exited_t {
+	int64_t queued_ns;	// received until picked up by a worker
+	int64_t spawn_ns;		// spawn until exec
+	int64_t run_ns;		// exec until exit
+	int64_t utime_us;		// user CPU time
+	int64_t stime_us;		// system CPU time
+	int64_t maxrss_kb;	// maximum resident set size
+	int32_t pid;
+	int32_t status;		// exit status, 128 + signal number if killed, 124 if timed out
+};
+
+struct addrinfo;
+
+bool daemon_run(const char * path, int workers, const char * const * builtins);
+struct addrinfo * daemon_resolve(const char * addr, bool passive);
+bool daemon_run_tcp(const char * addr, int workers,
+						const char * const * builtins);
+
+#endif // DAEMON_H_
+
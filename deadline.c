@@ -0,0 +1,472 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 02:05:51 AM
+ *
+ ***********************************************************************
+ */
+
+#include "deadline.h"
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <math.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include "pidfd.h"
+#include "stats.h"
+
+/*
+ * Deadlines of all jobs are watched by one thread using epoll, no thread
+ * per job. Each job has a timerfd and a pidfd, the pidfd tells us the job
+ * is gone so its timer can be dropped. Jobs are never reaped here. Signals
+ * are sent through the pidfd, a recycled PID is never hit. Background jobs
+ * are watched even without a deadline, the time they exited at is taken
+ * when their pidfd becomes readable. An exited job is remembered until its
+ * reaper asks whether it timed out and when it exited using deadline_reaped().
+ */
+
+static const char * MSG_TIMEOUT		= "\r<<< child %d timed out, sending SIGTERM\n";
+static const char * MSG_TIMEOUT_KILL	= "\r<<< child %d ignored SIGTERM, sending SIGKILL\n";
+
+/*
+ * epoll data of a watched fd: ID of the watch and kind of the fd
+ */
+#define WATCH_TIMER				1ULL
+#define WATCH_ID(X)				((X) >> 1)
+#define WATCH_IS_TIMER(X)		((X) & WATCH_TIMER)
+
+/*
+ * Longest deadline accepted, a year
+ */
+#define DEADLINE_MAX_MS			(365.0 * 24 * 60 * 60 * 1000)
+
+/**
+ * @brief  Watched job
+ */
+struct watch_t {
+	uint64_t id;
+	pid_t pid;
+	int pidfd;
+	int timerfd;					// -1 if there is no deadline
+	bool killing;					// timed out, SIGTERM was sent
+	int64_t exited_ns;			// stats_now() when it exited, 0 if running
+	struct watch_t * next;
+};
+
+static long long deadline_default_ms = 0;
+static unsigned long deadline_count = 0;
+
+/*
+ * Watchdog state, all but the counters is protected by deadline_mutex
+ */
+static pthread_t deadline_thread;
+static pthread_mutex_t deadline_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct watch_t * deadline_watches = NULL;
+static struct watch_t * deadline_exited = NULL;		// exited, not reaped yet
+static uint64_t deadline_last_id = 0;
+static int deadline_epoll = -1;
+static int deadline_event = -1;
+
+/**
+ * @brief  Parse duration, e.g. "500ms", "30s", "1.5m", "2h", plain number
+ *         is in seconds
+ *
+ * @param str duration
+ * @param ms where to store duration in milliseconds
+ *
+ * @return   true on success
+ */
+bool deadline_parse(const char * str, long long * ms) {
+	char * end;
+	double val;
+
+	val = strtod(str, &end);
+	if (end == str || val < 0)
+		return false;
+
+	if (! strcmp(end, "ms"))
+		;
+	else if (! *end || ! strcmp(end, "s"))
+		val *= 1000;
+	else if (! strcmp(end, "m"))
+		val *= 60 * 1000;
+	else if (! strcmp(end, "h"))
+		val *= 60 * 60 * 1000;
+	else
+		return false;
+
+	if (! isfinite(val) || val > DEADLINE_MAX_MS) // e.g. "nan", "inf"
+		return false;
+
+	*ms = (long long) val;
+
+	return true;
+}
+
+/**
+ * @brief  Get shell wide default deadline
+ *
+ * @return   deadline in milliseconds, 0 if none
+ */
+long long deadline_default() {
+	return deadline_default_ms;
+}
+
+/**
+ * @brief  Set shell wide default deadline
+ *
+ * @param ms deadline in milliseconds, 0 for none
+ */
+void deadline_set_default(long long ms) {
+	deadline_default_ms = ms;
+}
+
+/**
+ * @brief  Get number of timed out jobs
+ *
+ * @return   counter
+ */
+unsigned long deadline_timed_out() {
+	return __atomic_load_n(&deadline_count, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief  Arm timer
+ *
+ * @param fd timerfd to use
+ * @param ms timeout in milliseconds
+ *
+ * @return   true on success
+ */
+static
+bool timer_arm(int fd, long long ms) {
+	struct itimerspec its;
+
+	memset(&its, 0, sizeof(its));
+	its.it_value.tv_sec = ms / 1000;
+	its.it_value.tv_nsec = (ms % 1000) * 1000000;
+	if (ms <= 0) // zero would disarm it
+		its.it_value.tv_nsec = 1;
+
+	return timerfd_settime(fd, 0, &its, NULL) == 0;
+}
+
+/**
+ * @brief  Timer of a job expired, escalate
+ *
+ * @param pid PID of the job
+ * @param pidfd pidfd of the job
+ * @param timerfd timer of the job
+ * @param killing true if SIGTERM was already sent
+ */
+static
+void timer_expired(pid_t pid, int pidfd, int timerfd, bool killing) {
+	uint64_t expirations;
+
+	read(timerfd, &expirations, sizeof(expirations));
+
+	if (! killing) {
+		__atomic_add_fetch(&deadline_count, 1, __ATOMIC_RELAXED);
+		fprintf(stderr, MSG_TIMEOUT, pid);
+		sys_pidfd_send_signal(pidfd, SIGTERM);
+		timer_arm(timerfd, DEADLINE_KILL_MS);
+	} else {
+		fprintf(stderr, MSG_TIMEOUT_KILL, pid);
+		sys_pidfd_send_signal(pidfd, SIGKILL);
+	}
+}
+
+/**
+ * @brief  Close descriptors of a watch, deadline_mutex has to be held
+ *
+ * @param watch watch to use
+ */
+static
+void watch_close(struct watch_t * watch) {
+	if (watch->pidfd >= 0) {
+		epoll_ctl(deadline_epoll, EPOLL_CTL_DEL, watch->pidfd, NULL);
+		close(watch->pidfd);
+	}
+
+	if (watch->timerfd >= 0) {
+		epoll_ctl(deadline_epoll, EPOLL_CTL_DEL, watch->timerfd, NULL);
+		close(watch->timerfd);
+	}
+
+	watch->pidfd = watch->timerfd = -1;
+}
+
+/**
+ * @brief  Stop watching a job, deadline_mutex has to be held
+ *
+ * @param prev pointer to the watch in the list
+ */
+static
+void watch_remove(struct watch_t ** prev) {
+	struct watch_t * watch = *prev;
+
+	*prev = watch->next;
+	watch_close(watch);
+	free(watch);
+}
+
+/**
+ * @brief  Job exited, keep it until reaped, deadline_mutex has to be held
+ *
+ * @param prev pointer to the watch in the list
+ */
+static
+void watch_exited(struct watch_t ** prev) {
+	struct watch_t * watch = *prev;
+
+	*prev = watch->next;
+	watch_close(watch);
+	watch->exited_ns = stats_now();
+
+	watch->next = deadline_exited;
+	deadline_exited = watch;
+}
+
+/**
+ * @brief  Find watch of a job, deadline_mutex has to be held
+ *
+ * @param list list to search
+ * @param pid PID of the job
+ *
+ * @return   pointer to the watch in the list, points to NULL if not found
+ */
+static
+struct watch_t ** watch_find(struct watch_t ** list, pid_t pid) {
+	for (; *list && (*list)->pid != pid; list = &(*list)->next)
+		;
+
+	return list;
+}
+
+/**
+ * @brief  Watchdog thread
+ *
+ * @param p unused
+ *
+ * @return   NULL
+ */
+static
+void * deadline_run(void * p) {
+	struct epoll_event events[16];
+	struct watch_t ** prev;
+	sigset_t setchld;
+	int n, i;
+
+	(void) p;
+
+	// SIGCHLD is handled by other threads
+	sigemptyset(&setchld);
+	sigaddset(&setchld, SIGCHLD);
+	pthread_sigmask(SIG_BLOCK, &setchld, NULL);
+
+	for (;;) {
+		n = epoll_wait(deadline_epoll, events, sizeof(events) / sizeof(events[0]), -1);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0)
+			break;
+
+		pthread_mutex_lock(&deadline_mutex);
+		for (i = 0; i < n; ++i) {
+			if (events[i].data.u64 == 0) { // deadline_stop()
+				pthread_mutex_unlock(&deadline_mutex);
+				return NULL;
+			}
+
+			// look up by ID, the watch may be gone since epoll_wait()
+			for (prev = &deadline_watches; *prev; prev = &(*prev)->next)
+				if ((*prev)->id == WATCH_ID(events[i].data.u64))
+					break;
+
+			if (! *prev)
+				continue;
+
+			if (! WATCH_IS_TIMER(events[i].data.u64)) { // job exited
+				watch_exited(prev);
+			} else {
+				timer_expired((*prev)->pid, (*prev)->pidfd, (*prev)->timerfd,
+						(*prev)->killing);
+				(*prev)->killing = true;
+			}
+		}
+		pthread_mutex_unlock(&deadline_mutex);
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief  Start watchdog of jobs
+ *
+ * @return   true on success
+ */
+bool deadline_start() {
+	struct epoll_event ev;
+
+	deadline_epoll = epoll_create1(EPOLL_CLOEXEC);
+	deadline_event = eventfd(0, EFD_CLOEXEC);
+	if (deadline_epoll < 0 || deadline_event < 0) {
+		perror("deadline");
+		return false;
+	}
+
+	ev.events = EPOLLIN;
+	ev.data.u64 = 0;
+	epoll_ctl(deadline_epoll, EPOLL_CTL_ADD, deadline_event, &ev);
+
+	if (pthread_create(&deadline_thread, NULL, deadline_run, NULL) != 0) {
+		close(deadline_epoll);
+		deadline_epoll = -1;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Stop watchdog of jobs
+ */
+void deadline_stop() {
+	uint64_t one = 1;
+
+	if (deadline_epoll < 0)
+		return;
+
+	write(deadline_event, &one, sizeof(one));
+	pthread_join(deadline_thread, NULL);
+
+	while (deadline_watches)
+		watch_remove(&deadline_watches);
+	while (deadline_exited)
+		watch_remove(&deadline_exited);
+
+	close(deadline_event);
+	close(deadline_epoll);
+	deadline_epoll = -1;
+}
+
+/**
+ * @brief  Watch deadline of a job
+ *
+ * @param pid PID of the job
+ * @param pidfd pidfd of the job which is taken over, -1 to open one by PID
+ * @param ms deadline in milliseconds, 0 to watch only when it exits
+ *
+ * @return   true on success
+ */
+bool deadline_watch(pid_t pid, int pidfd, long long ms) {
+	struct epoll_event ev;
+	struct watch_t * watch;
+
+	if (deadline_epoll < 0 || ! (watch = (struct watch_t *) malloc(sizeof(struct watch_t)))) {
+		if (pidfd >= 0)
+			close(pidfd);
+		return false;
+	}
+
+	watch->pid = pid;
+	watch->killing = false;
+	watch->exited_ns = 0;
+	watch->pidfd = pidfd >= 0 ? pidfd : sys_pidfd_open(pid);
+	watch->timerfd = ms > 0 ? timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC) : -1;
+
+	if (watch->pidfd < 0 || (ms > 0 && (watch->timerfd < 0
+					|| ! timer_arm(watch->timerfd, ms)))) {
+		if (errno != ESRCH) // already gone is fine
+			perror("deadline");
+		if (watch->pidfd >= 0) close(watch->pidfd);
+		if (watch->timerfd >= 0) close(watch->timerfd);
+		free(watch);
+		return false;
+	}
+
+	pthread_mutex_lock(&deadline_mutex);
+	watch->id = ++deadline_last_id;
+	watch->next = deadline_watches;
+	deadline_watches = watch;
+
+	ev.events = EPOLLIN;
+	ev.data.u64 = watch->id << 1;
+	epoll_ctl(deadline_epoll, EPOLL_CTL_ADD, watch->pidfd, &ev);
+	if (watch->timerfd >= 0) {
+		ev.data.u64 = (watch->id << 1) | WATCH_TIMER;
+		epoll_ctl(deadline_epoll, EPOLL_CTL_ADD, watch->timerfd, &ev);
+	}
+	pthread_mutex_unlock(&deadline_mutex);
+
+	return true;
+}
+
+/**
+ * @brief  Has deadline of a job expired?
+ *
+ * @param pid PID of the job, not reaped yet
+ *
+ * @return   true if it timed out
+ */
+bool deadline_expired(pid_t pid) {
+	struct watch_t ** prev;
+	bool ret;
+
+	if (deadline_epoll < 0)
+		return false;
+
+	pthread_mutex_lock(&deadline_mutex);
+	if (! *(prev = watch_find(&deadline_watches, pid)))
+		prev = watch_find(&deadline_exited, pid);
+	ret = *prev && (*prev)->killing;
+	pthread_mutex_unlock(&deadline_mutex);
+
+	return ret;
+}
+
+/**
+ * @brief  Job was reaped, forget it
+ *
+ * Called by reapers of watched jobs, also from the SIGCHLD handler, which
+ * runs only while the executor waits and so never holds deadline_mutex.
+ *
+ * @param pid PID of the reaped job
+ * @param exited_ns where to store stats_now() when it exited, 0 if its
+ *        exit has not been seen yet, may be NULL
+ *
+ * @return   true if it timed out
+ */
+bool deadline_reaped(pid_t pid, int64_t * exited_ns) {
+	struct watch_t ** prev;
+	bool ret = false;
+
+	if (exited_ns)
+		*exited_ns = 0;
+
+	if (deadline_epoll < 0)
+		return false;
+
+	pthread_mutex_lock(&deadline_mutex);
+	if (! *(prev = watch_find(&deadline_watches, pid)))
+		prev = watch_find(&deadline_exited, pid);
+	if (*prev) {
+		ret = (*prev)->killing;
+		if (exited_ns)
+			*exited_ns = (*prev)->exited_ns;
+		watch_remove(prev);
+	}
+	pthread_mutex_unlock(&deadline_mutex);
+
+	return ret;
+}
@@ -0,0 +1,51 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 02:05:38 AM
+ *
+ ***********************************************************************
+ */
+
+#ifndef DEADLINE_H_
+#define DEADLINE_H_
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Per job prefix, e.g. timeout=30s
+ */
+#define DEADLINE_PREFIX		"timeout="
+
+/*
+ * Builtin to set shell wide default deadline
+ */
+#define DEADLINE_CMD			"deadline"
+
+/*
+ * How long a timed out job may take to exit after SIGTERM (ms)
+ */
+#ifndef DEADLINE_KILL_MS
+# define DEADLINE_KILL_MS	2000
+#endif // DEADLINE_KILL_MS
+
+/*
+ * Exit status of a timed out foreground job, as of timeout(1)
+ */
+#define DEADLINE_STATUS		124
+
+bool deadline_parse(const char * str, long long * ms);
+long long deadline_default();
+void deadline_set_default(long long ms);
+unsigned long deadline_timed_out();
+
+bool deadline_start();
+void deadline_stop();
+bool deadline_watch(pid_t pid, int pidfd, long long ms);
+bool deadline_expired(pid_t pid);
+bool deadline_reaped(pid_t pid, int64_t * exited_ns);
+
+#endif // DEADLINE_H_
+
@@ -0,0 +1,145 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 06:02:41 AM
+ *
+ ***********************************************************************
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <errno.h>
+
+#include "fdpass.h"
+
+/*
+ * Descriptors passed using SCM_RIGHTS are attached to the first byte of
+ * a buffer sent over a Unix stream socket. A receiver reading exactly the
+ * length of the buffer gets them together with it, no matter how the rest
+ * of the stream is split into reads.
+ */
+
+/**
+ * @brief  Send buffer with (optional) descriptors
+ *
+ * @param sock socket to use
+ * @param buf data to be sent
+ * @param len length of data
+ * @param fds descriptors to be passed
+ * @param nfds number of descriptors, at most FDPASS_MAX
+ *
+ * @return   true on success
+ */
+bool fdpass_send(int sock, const void * buf, size_t len, const int * fds, int nfds) {
+	union {
+		struct cmsghdr hdr;
+		char buf[CMSG_SPACE(FDPASS_MAX * sizeof(int))];
+	} control;
+	struct iovec iov = { (void *) buf, len };
+	struct msghdr msg;
+	struct cmsghdr * cmsg;
+	ssize_t ret;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+	if (nfds > 0) {
+		memset(&control, 0, sizeof(control));
+		msg.msg_control = control.buf;
+		msg.msg_controllen = CMSG_SPACE(nfds * sizeof(int));
+		cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(nfds * sizeof(int));
+		memcpy(CMSG_DATA(cmsg), fds, nfds * sizeof(int));
+	}
+
+	do {
+		ret = sendmsg(sock, &msg, MSG_NOSIGNAL);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret < 0)
+		return false;
+
+	// descriptors went with the first byte, send the rest as plain data
+	buf = (const char *) buf + ret;
+	len -= ret;
+	while (len > 0) {
+		ret = send(sock, buf, len, MSG_NOSIGNAL);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+		buf = (const char *) buf + ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Receive buffer with (optional) descriptors
+ *
+ * @param sock socket to use
+ * @param buf where to store data
+ * @param len length of data
+ * @param fds where to store received descriptors, they are close-on-exec
+ * @param nfds in: size of fds, out: number of received descriptors
+ *
+ * @return   true on success, false on error or end of file
+ */
+bool fdpass_recv(int sock, void * buf, size_t len, int * fds, int * nfds) {
+	union {
+		struct cmsghdr hdr;
+		char buf[CMSG_SPACE(FDPASS_MAX * sizeof(int))];
+	} control;
+	struct iovec iov = { buf, len };
+	struct msghdr msg;
+	struct cmsghdr * cmsg;
+	ssize_t ret;
+	int max = *nfds;
+	int n;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	do {
+		ret = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret <= 0)
+		return false;
+
+	*nfds = 0;
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+			n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+			*nfds = n < max ? n : max;
+			memcpy(fds, CMSG_DATA(cmsg), *nfds * sizeof(int));
+			while (n-- > *nfds) // more than the caller expects
+				close(((int *) CMSG_DATA(cmsg))[n]);
+		}
+	}
+
+	buf = (char *) buf + ret;
+	len -= ret;
+	while (len > 0) {
+		ret = recv(sock, buf, len, 0);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+		buf = (char *) buf + ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
@@ -0,0 +1,25 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 06:02:18 AM
+ *
+ ***********************************************************************
+ */
+
+#ifndef FDPASS_H_
+#define FDPASS_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Maximum number of descriptors passed with one buffer
+ */
+#define FDPASS_MAX			3
+
+bool fdpass_send(int sock, const void * buf, size_t len, const int * fds, int nfds);
+bool fdpass_recv(int sock, void * buf, size_t len, int * fds, int * nfds);
+
+#endif // FDPASS_H_
+
@@ -0,0 +1,508 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 08:33:05 AM
+ *
+ ***********************************************************************
+ */
+
+#include "lineedit.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <errno.h>
+
+#include "complete.h"
+
+/*
+ * The terminal is in raw mode only while a line is being edited, commands
+ * run with the cooked mode the shell was started with. Output processing
+ * is kept, so messages printed by other threads meanwhile still work.
+ * Input is read byte by byte, so nothing past the end of a line is taken
+ * from a command reading the terminal next.
+ */
+
+static const char * SEQ_CLEAR_EOL		= "\x1b[0K";
+static const char * SEQ_CLEAR_SCREEN	= "\x1b[H\x1b[2J";
+static const char * SEQ_BELL				= "\a";
+static const char * MSG_INTERRUPT		= "^C\n";
+static const char * MSG_MORE				= "... and %zu more\n";
+
+/*
+ * Control keys
+ */
+#define KEY_CTRL(c)			((c) & 0x1f)
+#define KEY_TAB				9
+#define KEY_ENTER				13
+#define KEY_ESC				27
+#define KEY_BACKSPACE		127
+
+/*
+ * Continuation byte of a UTF-8 character
+ */
+#define UTF8_CONT(c)			(((c) & 0xc0) == 0x80)
+
+/**
+ * @brief  Line being edited
+ */
+struct edit_t {
+	const char * prompt;
+	char * buf;
+	size_t size;					// of buf, room for '\n' and '\0' included
+	size_t len;
+	size_t pos;						// cursor
+	bool tab;						// last key was Tab
+};
+
+static struct termios edit_cooked;
+static bool edit_on = false;
+
+/*
+ * Result of the last completion, large for the stack of the reader
+ */
+static struct complete_t edit_complete_res;
+
+/**
+ * @brief  Enable line editing if stdin and stdout are a terminal
+ *
+ * @return   true if enabled
+ */
+bool lineedit_start() {
+	edit_on = isatty(STDIN_FILENO) && isatty(STDOUT_FILENO)
+		&& tcgetattr(STDIN_FILENO, &edit_cooked) == 0;
+
+	return edit_on;
+}
+
+/**
+ * @brief  Is line editing enabled?
+ *
+ * @return   true if so
+ */
+bool lineedit_enabled() {
+	return edit_on;
+}
+
+/**
+ * @brief  Read next byte of input
+ *
+ * @return   byte or -1 on end of file or error
+ */
+static
+int next_byte() {
+	unsigned char c;
+	ssize_t ret;
+
+	do {
+		ret = read(STDIN_FILENO, &c, 1);
+	} while (ret < 0 && errno == EINTR);
+
+	return ret == 1 ? c : -1;
+}
+
+/**
+ * @brief  Get width of the terminal
+ *
+ * @return   number of columns
+ */
+static
+size_t edit_columns() {
+	struct winsize ws;
+
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) < 0 || ws.ws_col == 0)
+		return LINEEDIT_COLUMNS;
+
+	return ws.ws_col;
+}
+
+/**
+ * @brief  Get number of characters of UTF-8 text, i.e. columns it takes
+ *
+ * @param s text
+ * @param n length of text in bytes
+ *
+ * @return   number of characters
+ */
+static
+size_t edit_width(const char * s, size_t n) {
+	size_t width = 0;
+
+	while (n-- > 0)
+		width += ! UTF8_CONT(*s++);
+
+	return width;
+}
+
+/**
+ * @brief  Find start of the character before an offset
+ *
+ * @param e line to use
+ * @param pos offset in the line
+ *
+ * @return   offset of the previous character, 0 at the start
+ */
+static
+size_t edit_prev(const struct edit_t * e, size_t pos) {
+	while (pos > 0 && UTF8_CONT(e->buf[--pos]))
+		;
+
+	return pos;
+}
+
+/**
+ * @brief  Find start of the character after an offset
+ *
+ * @param e line to use
+ * @param pos offset in the line
+ *
+ * @return   offset of the next character, length of the line at the end
+ */
+static
+size_t edit_next(const struct edit_t * e, size_t pos) {
+	if (pos < e->len)
+		pos++;
+	while (pos < e->len && UTF8_CONT(e->buf[pos]))
+		pos++;
+
+	return pos;
+}
+
+/**
+ * @brief  Redraw prompt and line, scrolled to keep the cursor visible
+ *
+ * @param e line to draw
+ */
+static
+void edit_refresh(const struct edit_t * e) {
+	char seq[1024];
+	size_t plen = strlen(e->prompt);
+	size_t cols = edit_columns();
+	const char * buf = e->buf;
+	size_t len = e->len;
+	size_t pos = e->pos;
+	size_t wlen = edit_width(buf, len);
+	size_t wpos = edit_width(buf, pos);
+	size_t skip;
+	int n;
+
+	// scroll by whole characters, columns are counted in characters
+	while (plen + wpos >= cols && pos > 0) {
+		for (skip = 1; skip < pos && UTF8_CONT(buf[skip]); ++skip)
+			;
+		buf += skip;
+		len -= skip;
+		pos -= skip;
+		wlen--;
+		wpos--;
+	}
+	while (plen + wlen > cols && len > pos) {
+		while (len > pos && UTF8_CONT(buf[--len]))
+			;
+		wlen--;
+	}
+
+	n = snprintf(seq, sizeof(seq), "\r%s%.*s%s", e->prompt, (int) len, buf, SEQ_CLEAR_EOL);
+	if (plen + wpos > 0 && n >= 0 && (size_t) n < sizeof(seq))
+		n += snprintf(seq + n, sizeof(seq) - n, "\r\x1b[%zuC", plen + wpos);
+
+	if (n > 0)
+		write(STDOUT_FILENO, seq, (size_t) n < sizeof(seq) ? (size_t) n : sizeof(seq) - 1);
+}
+
+/**
+ * @brief  Insert text at the cursor
+ *
+ * @param e line to use
+ * @param s text to insert
+ * @param n length of text
+ *
+ * @return   false if the line would be too long
+ */
+static
+bool edit_insert(struct edit_t * e, const char * s, size_t n) {
+	if (e->len + n + 2 > e->size) {
+		write(STDOUT_FILENO, SEQ_BELL, strlen(SEQ_BELL));
+		return false;
+	}
+
+	memmove(e->buf + e->pos + n, e->buf + e->pos, e->len - e->pos);
+	memcpy(e->buf + e->pos, s, n);
+	e->len += n;
+	e->pos += n;
+
+	return true;
+}
+
+/**
+ * @brief  Delete text
+ *
+ * @param e line to use
+ * @param from first character to delete
+ * @param to character after the last one to delete
+ */
+static
+void edit_delete(struct edit_t * e, size_t from, size_t to) {
+	memmove(e->buf + from, e->buf + to, e->len - to);
+	e->len -= to - from;
+	if (e->pos > to)
+		e->pos -= to - from;
+	else if (e->pos > from)
+		e->pos = from;
+}
+
+/**
+ * @brief  Print matches of a completion in columns below the line
+ *
+ * @param res completion to print
+ */
+static
+void edit_list(const struct complete_t * res) {
+	size_t width = 0, cols, i;
+
+	for (i = 0; i < res->nlist; ++i)
+		if (strlen(res->list[i]) > width)
+			width = strlen(res->list[i]);
+
+	width += 2;
+	if ((cols = edit_columns() / width) == 0)
+		cols = 1;
+
+	printf("\n");
+	for (i = 0; i < res->nlist; ++i)
+		printf("%-*s%s", (int) width, res->list[i],
+				(i + 1) % cols == 0 || i + 1 == res->nlist ? "\n" : "");
+	if (res->count > res->nlist)
+		printf(MSG_MORE, res->count - res->nlist);
+	fflush(stdout);
+}
+
+/**
+ * @brief  Complete word before the cursor
+ *
+ * The first word and words after job prefixes (containing '=') are
+ * commands unless they contain '/', other words are file names.
+ *
+ * @param e line to use
+ */
+static
+void edit_complete(struct edit_t * e) {
+	struct complete_t * res = &edit_complete_res;
+	char word[COMPLETE_NAME_LEN];
+	bool command = true;
+	size_t start, wlen, i;
+
+	for (start = e->pos; start > 0 && e->buf[start - 1] != ' '; --start)
+		;
+
+	wlen = e->pos - start;
+	if (wlen >= sizeof(word)) {
+		write(STDOUT_FILENO, SEQ_BELL, strlen(SEQ_BELL));
+		return;
+	}
+	memcpy(word, e->buf + start, wlen);
+	word[wlen] = '\0';
+
+	// any word before without '=' is the command
+	for (i = 0; i < start && command; ++i) {
+		if (e->buf[i] == ' ')
+			continue;
+		command = false;
+		for (; i < start && e->buf[i] != ' '; ++i)
+			if (e->buf[i] == '=')
+				command = true;
+	}
+
+	if (command && ! strchr(word, '/'))
+		complete_command(word, res);
+	else
+		complete_file(word, res);
+
+	if (res->count == 0) {
+		write(STDOUT_FILENO, SEQ_BELL, strlen(SEQ_BELL));
+		return;
+	}
+
+	if (strlen(res->common) > wlen || res->count == 1) {
+		edit_insert(e, res->common + wlen, strlen(res->common) - wlen);
+		if (res->count == 1)
+			edit_insert(e, res->dir ? "/" : " ", 1);
+	} else if (e->tab) {
+		edit_list(res); // second Tab without progress
+	} else {
+		write(STDOUT_FILENO, SEQ_BELL, strlen(SEQ_BELL));
+	}
+}
+
+/**
+ * @brief  Handle escape sequence of a key
+ *
+ * @param e line to use
+ */
+static
+void edit_escape(struct edit_t * e) {
+	int c, num = 0;
+
+	if ((c = next_byte()) != '[' && c != 'O')
+		return;
+
+	c = next_byte();
+	while (c >= '0' && c <= '9') { // e.g. ESC [ 3 ~
+		num = num * 10 + c - '0';
+		c = next_byte();
+	}
+
+	if (c == 'D')
+		e->pos = edit_prev(e, e->pos);
+	else if (c == 'C')
+		e->pos = edit_next(e, e->pos);
+	else if (c == 'H' || (c == '~' && (num == 1 || num == 7)))
+		e->pos = 0;
+	else if (c == 'F' || (c == '~' && (num == 4 || num == 8)))
+		e->pos = e->len;
+	else if (c == '~' && num == 3 && e->pos < e->len)
+		edit_delete(e, e->pos, edit_next(e, e->pos));
+}
+
+/**
+ * @brief  Read a line using the line editor
+ *
+ * @param prompt prompt to print
+ * @param buf where to store the line, '\n' and '\0' terminated
+ * @param size size of buf
+ *
+ * @return   length of the line with '\n', 0 on end of file, -1 on error
+ */
+ssize_t lineedit_read(const char * prompt, char * buf, size_t size) {
+	struct termios raw = edit_cooked;
+	struct edit_t e = { prompt, buf, size, 0, 0, false };
+	ssize_t ret = -1;
+	size_t i;
+	int c;
+
+	// no signals either, ^C is handled below
+	raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+	raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+	raw.c_cc[VMIN] = 1;
+	raw.c_cc[VTIME] = 0;
+
+	// typed ahead input is kept
+	if (tcsetattr(STDIN_FILENO, TCSADRAIN, &raw) < 0)
+		return -1;
+
+	edit_refresh(&e);
+
+	while (ret < 0) {
+		switch ((c = next_byte())) {
+			case -1:
+				if (e.len > 0) { // last line without '\n'
+					buf[e.len++] = '\n';
+					ret = e.len;
+				} else {
+					ret = 0;
+				}
+				break;
+
+			case KEY_ENTER:
+			case '\n':
+				buf[e.len++] = '\n';
+				ret = e.len;
+				break;
+
+			case KEY_CTRL('d'):
+				if (e.len == 0)
+					ret = 0;
+				else if (e.pos < e.len)
+					edit_delete(&e, e.pos, edit_next(&e, e.pos));
+				break;
+
+			case KEY_CTRL('c'):
+				write(STDOUT_FILENO, MSG_INTERRUPT, strlen(MSG_INTERRUPT));
+				e.len = e.pos = 0;
+				break;
+
+			case KEY_BACKSPACE:
+			case KEY_CTRL('h'):
+				if (e.pos > 0)
+					edit_delete(&e, edit_prev(&e, e.pos), e.pos);
+				break;
+
+			case KEY_CTRL('a'):
+				e.pos = 0;
+				break;
+
+			case KEY_CTRL('e'):
+				e.pos = e.len;
+				break;
+
+			case KEY_CTRL('b'):
+				e.pos = edit_prev(&e, e.pos);
+				break;
+
+			case KEY_CTRL('f'):
+				e.pos = edit_next(&e, e.pos);
+				break;
+
+			case KEY_CTRL('k'):
+				edit_delete(&e, e.pos, e.len);
+				break;
+
+			case KEY_CTRL('u'):
+				edit_delete(&e, 0, e.pos);
+				break;
+
+			case KEY_CTRL('w'):
+				for (i = e.pos; i > 0 && buf[i - 1] == ' '; --i)
+					;
+				for (; i > 0 && buf[i - 1] != ' '; --i)
+					;
+				edit_delete(&e, i, e.pos);
+				break;
+
+			case KEY_CTRL('l'):
+				write(STDOUT_FILENO, SEQ_CLEAR_SCREEN, strlen(SEQ_CLEAR_SCREEN));
+				break;
+
+			case KEY_TAB:
+				edit_complete(&e);
+				break;
+
+			case KEY_ESC:
+				edit_escape(&e);
+				break;
+
+			default:
+				if (c >= ' ') {
+					char ch = c;
+
+					// typing at the end of a line which fits, echo only
+					if (e.pos == e.len
+							&& strlen(prompt) + edit_width(buf, e.len) + 1 < edit_columns()) {
+						if (edit_insert(&e, &ch, 1))
+							write(STDOUT_FILENO, &ch, 1);
+						e.tab = false;
+						continue;
+					}
+					edit_insert(&e, &ch, 1);
+				}
+		}
+
+		e.tab = c == KEY_TAB;
+
+		if (ret < 0)
+			edit_refresh(&e);
+	}
+
+	buf[e.len] = '\0';
+
+	if (ret > 0)
+		write(STDOUT_FILENO, "\n", 1);
+
+	tcsetattr(STDIN_FILENO, TCSADRAIN, &edit_cooked);
+
+	return ret;
+}
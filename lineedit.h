@@ -0,0 +1,26 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 08:31:44 AM
+ *
+ ***********************************************************************
+ */
+
+#ifndef LINEEDIT_H_
+#define LINEEDIT_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+/*
+ * Terminal width if it cannot be obtained
+ */
+#define LINEEDIT_COLUMNS		80
+
+bool lineedit_start();
+bool lineedit_enabled();
+ssize_t lineedit_read(const char * prompt, char * buf, size_t size);
+
+#endif // LINEEDIT_H_
@@ -0,0 +1,574 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 10:21:19 PM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+#include "memo.h"
+#include "deadline.h"
+
+/*
+ * Store entry is "<hash>.memo": fixed size header, key, cached stdout.
+ * The key holds argv, selected environment and digest of the input file
+ * and it is compared on every hit, so a hash collision is just a miss.
+ */
+#define MEMO_SUFFIX				".memo"
+#define MEMO_HDR_FMT				"PROJ3MEMO 1 %3d %10zu\n"
+#define MEMO_HDR_SCAN			"PROJ3MEMO 1 %d %zu"
+#define MEMO_HDR_LEN				27
+
+/*
+ * Files being stored, left behind if the shell was killed meanwhile
+ */
+#define MEMO_TMP_PREFIX			".tmp."
+#define MEMO_TMP_MAX_AGE_S		3600
+
+/*
+ * memo_replay() wrote part of the output and failed
+ */
+#define MEMO_REPLAY_FAILED		(-2)
+
+/*
+ * FNV-1a, 64 bit
+ */
+#define FNV_OFFSET				0xcbf29ce484222325ULL
+#define FNV_PRIME					0x100000001b3ULL
+
+static const char * ERR_MEMO_BACKGROUND	= "memo: memoized command can not run in background\n";
+static const char * ERR_MEMO_STORE			= "memo: store is not available\n";
+static const char * ERR_MEMO_INPUT			= "memo: unable to read input\n";
+static const char * ERR_MEMO_REPLAY		= "memo: unable to replay output\n";
+static const char * MSG_MEMO_STATS			=
+	"memo: %lu hits, %lu misses, %lu evictions, %zu entries, %zu bytes in %s\n";
+
+/**
+ * @brief  Store entry found by memo_scan()
+ */
+struct memo_entry_t {
+	char name[NAME_MAX + 1];
+	size_t size;
+	long long mtime;
+};
+
+/*
+ * Statistics of this shell session
+ */
+static unsigned long memo_hits = 0;
+static unsigned long memo_misses = 0;
+static unsigned long memo_evictions = 0;
+
+/*
+ * Store directory, resolved on first use
+ */
+static char memo_dir[PATH_MAX];
+
+/**
+ * @brief  Hash buffer using FNV-1a
+ *
+ * @param hash hash to continue with
+ * @param data buffer to be hashed
+ * @param len length of buffer
+ *
+ * @return   new hash
+ */
+static inline
+uint64_t fnv1a(uint64_t hash, const void * data, size_t len) {
+	const unsigned char * p = (const unsigned char *) data;
+
+	while (len--) {
+		hash ^= *p++;
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/**
+ * @brief  Get directory of the store, create it if needed
+ *
+ * MEMO_DIR environment variable overrides $HOME/.cache/proj3-memo
+ *
+ * @return   path or NULL if not available
+ */
+static
+const char * memo_store() {
+	const char * dir = getenv("MEMO_DIR");
+	const char * home = getenv("HOME");
+
+	if (memo_dir[0])
+		return memo_dir;
+
+	if (dir && dir[0]) {
+		snprintf(memo_dir, sizeof(memo_dir), "%s", dir);
+	} else if (home && home[0]) {
+		snprintf(memo_dir, sizeof(memo_dir), "%s/.cache", home);
+		mkdir(memo_dir, 0700);
+		strncat(memo_dir, "/proj3-memo", sizeof(memo_dir) - strlen(memo_dir) - 1);
+	} else {
+		snprintf(memo_dir, sizeof(memo_dir), "/tmp/proj3-memo-%d", (int) getuid());
+	}
+
+	if (mkdir(memo_dir, 0700) < 0 && errno != EEXIST) {
+		memo_dir[0] = '\0';
+		return NULL;
+	}
+
+	return memo_dir;
+}
+
+/**
+ * @brief  Size bound of the store, MEMO_MAX environment variable overrides
+ *         MEMO_MAX_SIZE
+ *
+ * @return   size in bytes
+ */
+static
+size_t memo_max_size() {
+	const char * max = getenv("MEMO_MAX");
+	char * end;
+	unsigned long long ret;
+
+	if (! max || ! max[0])
+		return MEMO_MAX_SIZE;
+
+	ret = strtoull(max, &end, 10);
+	if (*end == 'k' || *end == 'K')
+		ret <<= 10;
+	else if (*end == 'm' || *end == 'M')
+		ret <<= 20;
+	else if (*end == 'g' || *end == 'G')
+		ret <<= 30;
+
+	return ret;
+}
+
+/**
+ * @brief  Build key of a command
+ *
+ * @param argv command to be run
+ * @param input input file or NULL
+ * @param key where to store allocated key
+ * @param length where to store length of key
+ *
+ * @return   true on success, false also if input could not be read whole
+ */
+static
+bool memo_key(char ** argv, const char * input, char ** key, size_t * length) {
+	const char * names = getenv("MEMO_ENV");
+	char buf[1 << 16];
+	char * copy, * name, * save, * value;
+	uint64_t hash = FNV_OFFSET;
+	size_t size = 0;
+	ssize_t num_read;
+	FILE * f;
+	int fd;
+
+	f = open_memstream(key, length);
+	if (! f)
+		return false;
+
+	for (; *argv; ++argv) {
+		fputs(*argv, f);
+		fputc('\0', f);
+	}
+
+	// selected environment variables
+	if (names && (copy = strdup(names))) {
+		for (name = strtok_r(copy, ":", &save); name;
+				name = strtok_r(NULL, ":", &save)) {
+			value = getenv(name);
+			fprintf(f, "\nenv:%s=%s", name, value ? value : "");
+			fputc(value ? '\0' : '\1', f);
+		}
+		free(copy);
+	}
+
+	// contents of the input file
+	if (input) {
+		if ((fd = open(input, O_RDONLY | O_CLOEXEC)) < 0) {
+			fclose(f); free(*key);
+			return false;
+		}
+
+		while ((num_read = read(fd, buf, sizeof(buf))) != 0) {
+			if (num_read < 0 && errno == EINTR)
+				continue;
+			if (num_read < 0) { // partial input must not hit
+				close(fd); fclose(f); free(*key);
+				return false;
+			}
+			hash = fnv1a(hash, buf, num_read);
+			size += num_read;
+		}
+		close(fd);
+
+		fprintf(f, "\ninput:%016llx:%zu", (unsigned long long) hash, size);
+	}
+
+	if (fclose(f) != 0) {
+		free(*key);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Copy rest of a file to a descriptor
+ *
+ * @param from source descriptor
+ * @param to destination descriptor
+ * @param wrote set to true once anything is written, may be NULL
+ *
+ * @return   true on success
+ */
+static
+bool copy_fd(int from, int to, bool * wrote) {
+	const struct timespec zero = { 0, 0 };
+	char buf[1 << 16];
+	ssize_t num_read, num_written, off;
+	sigset_t setpipe, old;
+	bool ok = true;
+
+	// a reader gone is reported by EPIPE, it must not kill the shell
+	sigemptyset(&setpipe);
+	sigaddset(&setpipe, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &setpipe, &old);
+
+	while (ok && (num_read = read(from, buf, sizeof(buf))) != 0) {
+		if (num_read < 0) {
+			ok = errno == EINTR;
+			continue;
+		}
+
+		for (off = 0; ok && off < num_read; off += num_written) {
+			num_written = write(to, buf + off, num_read - off);
+			if (num_written < 0 && errno == EINTR)
+				num_written = 0;
+			else if (num_written < 0)
+				ok = false;
+			else if (wrote && num_written > 0)
+				*wrote = true;
+		}
+	}
+
+	// drop SIGPIPE raised meanwhile before it is unblocked
+	while (sigtimedwait(&setpipe, NULL, &zero) > 0)
+		;
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	return ok;
+}
+
+/**
+ * @brief  Replay cached entry if it matches the key
+ *
+ * @param path path of the entry
+ * @param key key of the command
+ * @param length length of key
+ * @param fd_out where to replay stdout to
+ *
+ * @return   cached exit status, -1 on miss, MEMO_REPLAY_FAILED if it failed
+ *           after writing part of the output (running the command again
+ *           would print it twice)
+ */
+static
+int memo_replay(const char * path, const char * key, size_t length, int fd_out) {
+	char hdr[MEMO_HDR_LEN + 1];
+	char * stored;
+	size_t stored_len;
+	bool wrote = false;
+	int status;
+	int fd;
+	bool hit;
+
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		return -1;
+
+	hdr[MEMO_HDR_LEN] = '\0';
+	if (read(fd, hdr, MEMO_HDR_LEN) != MEMO_HDR_LEN
+			|| sscanf(hdr, MEMO_HDR_SCAN, &status, &stored_len) != 2
+			|| stored_len != length
+			|| ! (stored = (char *) malloc(length + 1))) {
+		close(fd);
+		return -1;
+	}
+
+	hit = read(fd, stored, length) == (ssize_t) length
+			&& ! memcmp(stored, key, length);
+	free(stored);
+
+	if (! hit || ! copy_fd(fd, fd_out, &wrote)) {
+		close(fd);
+		return wrote ? MEMO_REPLAY_FAILED : -1;
+	}
+
+	futimens(fd, NULL); // recently used, see memo_evict()
+	close(fd);
+
+	return status;
+}
+
+/**
+ * @brief  Compare entries by age for qsort()
+ */
+static
+int cmp_entry(const void * a, const void * b) {
+	long long x = ((const struct memo_entry_t *) a)->mtime;
+	long long y = ((const struct memo_entry_t *) b)->mtime;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief  List entries of the store
+ *
+ * @param dir store directory
+ * @param entries where to store allocated entries
+ * @param total where to store total size of entries
+ * @param clean remove files of runs which did not finish storing, i.e. not
+ *              written for MEMO_TMP_MAX_AGE_S
+ *
+ * @return   number of entries
+ */
+static
+size_t memo_scan(const char * dir, struct memo_entry_t ** entries, size_t * total,
+						bool clean) {
+	char path[PATH_MAX];
+	struct memo_entry_t * tmp;
+	struct dirent * ent;
+	struct stat st;
+	size_t count = 0, alloc = 0, len;
+	DIR * d;
+
+	*entries = NULL;
+	*total = 0;
+
+	if (! (d = opendir(dir)))
+		return 0;
+
+	while ((ent = readdir(d))) {
+		if (clean && ! strncmp(ent->d_name, MEMO_TMP_PREFIX, strlen(MEMO_TMP_PREFIX))) {
+			snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+			if (stat(path, &st) == 0 && st.st_mtime + MEMO_TMP_MAX_AGE_S < time(NULL))
+				unlink(path);
+			continue;
+		}
+
+		len = strlen(ent->d_name);
+		if (len <= strlen(MEMO_SUFFIX)
+				|| strcmp(ent->d_name + len - strlen(MEMO_SUFFIX), MEMO_SUFFIX))
+			continue;
+
+		snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+		if (stat(path, &st) < 0)
+			continue;
+
+		if (count == alloc) {
+			alloc = alloc ? 2 * alloc : 64;
+			tmp = (struct memo_entry_t *) realloc(*entries, alloc * sizeof(**entries));
+			if (! tmp)
+				break;
+			*entries = tmp;
+		}
+
+		snprintf((*entries)[count].name, sizeof((*entries)[count].name), "%s", ent->d_name);
+		(*entries)[count].size = st.st_size;
+		(*entries)[count].mtime = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+		*total += st.st_size;
+		count++;
+	}
+
+	closedir(d);
+
+	return count;
+}
+
+/**
+ * @brief  Remove least recently used entries until the store fits into
+ *         its size bound
+ *
+ * @param dir store directory
+ */
+static
+void memo_evict(const char * dir) {
+	char path[PATH_MAX];
+	struct memo_entry_t * entries;
+	size_t count, total, max, i;
+
+	max = memo_max_size();
+	count = memo_scan(dir, &entries, &total, true);
+
+	if (total > max) {
+		qsort(entries, count, sizeof(*entries), cmp_entry);
+
+		for (i = 0; i < count && total > max; ++i) {
+			snprintf(path, sizeof(path), "%s/%s", dir, entries[i].name);
+			if (unlink(path) == 0) {
+				total -= entries[i].size;
+				memo_evictions++;
+			}
+		}
+	}
+
+	free(entries);
+}
+
+/**
+ * @brief  Run command and store its stdout and exit status
+ *
+ * @param argv command to be run
+ * @param attr attributes of the command
+ * @param dir store directory
+ * @param path path of the entry
+ * @param key key of the command
+ * @param length length of key
+ *
+ * @return   exit status, -1 on error
+ */
+static
+int memo_run(char ** argv, const struct spawn_attr_t * attr, const char * dir,
+				const char * path, const char * key, size_t length) {
+	struct spawn_attr_t child = *attr;
+	char hdr[MEMO_HDR_LEN + 1];
+	char tmp[PATH_MAX];
+	int status = -1;
+	pid_t pid;
+	int fd;
+
+	snprintf(tmp, sizeof(tmp), "%s/.tmp.XXXXXX", dir);
+	if ((fd = mkostemp(tmp, O_CLOEXEC)) < 0)
+		return -1;
+
+	snprintf(hdr, sizeof(hdr), MEMO_HDR_FMT, 0, length);
+	if (write(fd, hdr, MEMO_HDR_LEN) != MEMO_HDR_LEN
+			|| write(fd, key, length) != (ssize_t) length)
+		goto out;
+
+	child.fd_out = fd;
+	if ((pid = spawn_command(argv, &child)) < 0)
+		goto out;
+	status = spawn_wait(pid);
+
+	// replay what we have just stored
+	if (lseek(fd, MEMO_HDR_LEN + length, SEEK_SET) < 0
+			|| ! copy_fd(fd, attr->fd_out >= 0 ? attr->fd_out : STDOUT_FILENO, NULL))
+		goto out;
+
+	// killed and timed out commands are not cached
+	if (status >= 0 && status < 128 && status != DEADLINE_STATUS) {
+		snprintf(hdr, sizeof(hdr), MEMO_HDR_FMT, status, length);
+		if (pwrite(fd, hdr, MEMO_HDR_LEN, 0) == MEMO_HDR_LEN
+				&& rename(tmp, path) == 0)
+			tmp[0] = '\0';
+	}
+
+out:
+	close(fd);
+	if (tmp[0])
+		unlink(tmp);
+
+	return status;
+}
+
+/**
+ * @brief  Print statistics of the store
+ */
+static
+void memo_stats() {
+	struct memo_entry_t * entries = NULL;
+	const char * dir = memo_store();
+	size_t count = 0, total = 0;
+
+	if (dir) {
+		count = memo_scan(dir, &entries, &total, false);
+		free(entries);
+	}
+
+	fprintf(stderr, MSG_MEMO_STATS, memo_hits, memo_misses, memo_evictions,
+			count, total, dir ? dir : "-");
+}
+
+/**
+ * @brief  Run memoized command, replay its stdout and exit status from the
+ *         store when run with the same arguments and input before
+ *
+ * Without a command, statistics of the store are printed.
+ *
+ * @param argv NULL terminated vector, argv[0] is the "memo" prefix
+ * @param cmd_list parsed command, used for the input file
+ * @param attr attributes of the command
+ *
+ * @return   exit status of the command, -1 on error
+ */
+int memo_command(char ** argv, const struct parse_list_t * cmd_list,
+						const struct spawn_attr_t * attr) {
+	char path[PATH_MAX];
+	const char * dir;
+	char * key;
+	size_t length;
+	uint64_t hash;
+	int status;
+
+	++argv; // skip prefix
+
+	if (! argv[0]) {
+		memo_stats();
+		return 0;
+	}
+
+	if (attr->background) {
+		write(2, ERR_MEMO_BACKGROUND, strlen(ERR_MEMO_BACKGROUND));
+		return -1;
+	}
+
+	if (! (dir = memo_store())) {
+		write(2, ERR_MEMO_STORE, strlen(ERR_MEMO_STORE));
+		return -1;
+	}
+
+	if (! memo_key(argv, cmd_list->input, &key, &length)) {
+		write(2, ERR_MEMO_INPUT, strlen(ERR_MEMO_INPUT));
+		return -1;
+	}
+
+	hash = fnv1a(FNV_OFFSET, key, length);
+	snprintf(path, sizeof(path), "%s/%016llx" MEMO_SUFFIX, dir, (unsigned long long) hash);
+
+	status = memo_replay(path, key, length,
+			attr->fd_out >= 0 ? attr->fd_out : STDOUT_FILENO);
+
+	if (status == MEMO_REPLAY_FAILED) {
+		write(2, ERR_MEMO_REPLAY, strlen(ERR_MEMO_REPLAY));
+		status = -1;
+	} else if (status >= 0) {
+		memo_hits++;
+	} else {
+		memo_misses++;
+		status = memo_run(argv, attr, dir, path, key, length);
+		memo_evict(dir);
+	}
+
+	free(key);
+
+	return status;
+}
+
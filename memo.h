@@ -0,0 +1,32 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 10:21:06 PM
+ *
+ ***********************************************************************
+ */
+
+#ifndef MEMO_H_
+#define MEMO_H_
+
+#include "parse.h"
+#include "spawn.h"
+
+/*
+ * Builtin prefix for memoized commands
+ */
+#define MEMO_CMD				"memo"
+
+/*
+ * Default size bound of the store in bytes
+ */
+#ifndef MEMO_MAX_SIZE
+# define MEMO_MAX_SIZE		(64 << 20)
+#endif // MEMO_MAX_SIZE
+
+int memo_command(char ** argv, const struct parse_list_t * cmd_list,
+						const struct spawn_attr_t * attr);
+
+#endif // MEMO_H_
+
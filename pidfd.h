@@ -0,0 +1,48 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 01:20:12 AM
+ *
+ ***********************************************************************
+ */
+
+#ifndef PIDFD_H_
+#define PIDFD_H_
+
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <signal.h>
+
+/*
+ * glibc got pidfd wrappers only recently, use the system calls directly
+ */
+
+/**
+ * @brief  Obtain pidfd referring to a process
+ *
+ * @param pid process to use
+ *
+ * @return   pidfd or -1 on failure
+ */
+static inline
+int sys_pidfd_open(pid_t pid) {
+	return syscall(SYS_pidfd_open, pid, 0);
+}
+
+/**
+ * @brief  Send signal to a process referred by pidfd
+ *
+ * @param pidfd process to use
+ * @param sig signal to be sent
+ *
+ * @return   0 on success, -1 on failure
+ */
+static inline
+int sys_pidfd_send_signal(int pidfd, int sig) {
+	return syscall(SYS_pidfd_send_signal, pidfd, sig, NULL, 0);
+}
+
+#endif // PIDFD_H_
+
@@ -13,6 +13,36 @@
 #include <stdlib.h>
 #include <signal.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/wait.h>
+
+#include "pidfd.h"
+
+/*
+ * How long to wait for jobs killed by SIGKILL
+ */
+#define PIDLIST_KILL_WAIT_MS	1000
+
+/*
+ * Polling period for jobs without pidfd (kernels older than 5.3)
+ */
+#define PIDLIST_POLL_MS			10
+
+/**
+ * @brief  Current monotonic time in milliseconds
+ *
+ * @return   time
+ */
+static inline
+long long now_ms() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
 
 /**
  * @brief  Insert PID into PID list
@@ -20,19 +50,27 @@
  * @param pidlist PID list to use
  * @param pid pid to be inserted
  *
- * @return true on success
+ * @return inserted item or NULL on failure
  */
-bool pidlist_insert(struct pidlist_t * pidlist, pid_t pid) {
+struct pidlist_item_t * pidlist_insert(struct pidlist_t * pidlist, pid_t pid) {
 	struct pidlist_item_t * item;
 
 	item = (struct pidlist_item_t *) malloc(sizeof(struct pidlist_item_t));
-	if (! item) return false;
+	if (! item) return NULL;
+
+	if (! pidlist->first) // no jobs, start numbering again
+		pidlist->last_job = 0;
 
 	item->pid = pid;
+	item->job = ++pidlist->last_job;
+	item->name[0] = '\0';
+	place_init(&item->place);
+	prio_init(&item->prio);
+	item->agent = 0;
 	item->next = pidlist->first;
 	pidlist->first = item;
 
-	return true;
+	return item;
 }
 
 /**
@@ -56,6 +94,24 @@ struct pidlist_item_t * pidlist_find(struct pidlist_t * pidlist, pid_t pid) {
 	return NULL;
 }
 
+/**
+ * @brief  Find job in PID list
+ *
+ * @param pidlist PID list to use
+ * @param job job ID to look for
+ *
+ * @return found item or NULL
+ */
+struct pidlist_item_t * pidlist_find_job(struct pidlist_t * pidlist, unsigned int job) {
+	struct pidlist_item_t * it;
+
+	for (it = pidlist->first; it; it = it->next)
+		if (it->job == job)
+			return it;
+
+	return NULL;
+}
+
 /**
  * @brief  Remove item from PID list
  *
@@ -91,7 +147,10 @@ void pidlist_kill_free(struct pidlist_t * pidlist) {
 	struct pidlist_item_t * it;
 	struct pidlist_item_t * tmp;
 
-	for (it = pidlist->first; it; /**/) {
+	it = pidlist->first;
+	pidlist->first = NULL; // detach, SIGCHLD handler may walk the list
+
+	while (it) {
 		tmp = it;
 		it = it->next;
 		kill(tmp->pid, SIGTERM);
@@ -99,3 +158,136 @@ void pidlist_kill_free(struct pidlist_t * pidlist) {
 	}
 }
 
+/**
+ * @brief  Send signal to a job, using pidfd if available
+ *
+ * @param pfd pidfd of the job or -1
+ * @param pid PID of the job
+ * @param sig signal to be sent
+ */
+static inline
+void drain_signal(int pfd, pid_t pid, int sig) {
+	if (pfd >= 0)
+		sys_pidfd_send_signal(pfd, sig);
+	else
+		kill(pid, sig);
+}
+
+/**
+ * @brief  Terminate all jobs concurrently and free PID list
+ *
+ * All jobs get SIGTERM at once and they are reaped as they exit. Jobs still
+ * running after grace_ms get SIGKILL. SIGCHLD handler must not reap jobs
+ * while draining.
+ *
+ * @param pidlist PID list to use
+ * @param grace_ms how long jobs may take to exit after SIGTERM
+ * @param on_kill called for jobs which get SIGKILL, may be NULL
+ * @param res where to store result
+ */
+void pidlist_drain(struct pidlist_t * pidlist, int grace_ms,
+						pidlist_kill_cb_t on_kill, struct pidlist_drain_t * res) {
+	struct pidlist_item_t ** items;
+	struct pidlist_item_t * it;
+	struct pidlist_item_t * next;
+	struct pollfd * pfds;
+	long long start, deadline, timeout;
+	unsigned int n = 0, alive = 0, i;
+	bool killing = false;
+	bool polling = false;
+	pid_t ret;
+
+	res->jobs = res->killed = res->left = 0;
+	start = now_ms();
+
+	for (it = pidlist->first; it; it = it->next)
+		n++;
+
+	items = (struct pidlist_item_t **) malloc(n * sizeof(*items));
+	pfds = (struct pollfd *) malloc(n * sizeof(*pfds));
+	if (! items || ! pfds) { // at least do not leave them running
+		free(items); free(pfds);
+		pidlist_kill_free(pidlist);
+		res->elapsed_ms = now_ms() - start;
+		return;
+	}
+
+	// send SIGTERM to all at once
+	for (it = pidlist->first, i = 0; it; it = next, ++i) {
+		next = it->next;
+		items[i] = it;
+		pfds[i].fd = sys_pidfd_open(it->pid);
+		pfds[i].events = POLLIN;
+		pfds[i].revents = 0;
+
+		if (pfds[i].fd < 0 && errno == ESRCH) { // already reaped
+			free(it);
+			items[i] = NULL;
+			continue;
+		}
+
+		polling |= pfds[i].fd < 0;
+		drain_signal(pfds[i].fd, it->pid, SIGTERM);
+		alive++;
+	}
+
+	res->jobs = n;
+	pidlist->first = NULL;
+
+	deadline = start + grace_ms;
+	while (alive > 0) {
+		timeout = deadline - now_ms();
+
+		if (timeout <= 0 && ! killing) { // grace period is over
+			for (i = 0; i < n; ++i) {
+				if (! items[i])
+					continue;
+
+				if (on_kill)
+					on_kill(items[i]);
+				drain_signal(pfds[i].fd, items[i]->pid, SIGKILL);
+				res->killed++;
+			}
+
+			killing = true;
+			deadline = now_ms() + PIDLIST_KILL_WAIT_MS;
+			continue;
+		} else if (timeout <= 0) {
+			break;
+		}
+
+		if (polling && timeout > PIDLIST_POLL_MS)
+			timeout = PIDLIST_POLL_MS;
+
+		if (poll(pfds, n, timeout) < 0 && errno != EINTR)
+			break;
+
+		for (i = 0; i < n; ++i) {
+			if (! items[i] || (pfds[i].fd >= 0 && ! (pfds[i].revents & POLLIN)))
+				continue;
+
+			ret = waitpid(items[i]->pid, NULL, WNOHANG);
+			if (ret == items[i]->pid || (ret < 0 && errno == ECHILD)) {
+				if (pfds[i].fd >= 0)
+					close(pfds[i].fd);
+				pfds[i].fd = -1; // ignored by poll()
+				free(items[i]);
+				items[i] = NULL;
+				alive--;
+			}
+		}
+	}
+
+	for (i = 0; i < n; ++i) {
+		if (pfds[i].fd >= 0)
+			close(pfds[i].fd);
+		free(items[i]);
+	}
+
+	res->left = alive;
+	res->elapsed_ms = now_ms() - start;
+
+	free(items);
+	free(pfds);
+}
+
@@ -15,19 +15,48 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+#include "place.h"
+#include "prio.h"
+
+/*
+ * Length of stored command name
+ */
+#define PIDLIST_NAME_LEN		32
+
 /**
  * @brief  PID list item
  */
 struct pidlist_item_t {
 	pid_t pid;
+	unsigned int job;
+	char name[PIDLIST_NAME_LEN];
+	struct place_t place;
+	struct prio_t prio;
+	unsigned int agent;			// agent the job was dispatched to, 0 if local
 	struct pidlist_item_t * next;
 };
 
+/**
+ * @brief  Result of pidlist_drain()
+ */
+struct pidlist_drain_t {
+	unsigned int jobs;
+	unsigned int killed;		// ignored SIGTERM for the whole grace period
+	unsigned int left;		// survived even SIGKILL, not reaped
+	long long elapsed_ms;
+};
+
+/**
+ * @brief  Called for each job which has to be killed by pidlist_drain()
+ */
+typedef void (* pidlist_kill_cb_t)(const struct pidlist_item_t * item);
+
 /**
  * @brief  Header of PID list
  */
 struct pidlist_t {
 	struct pidlist_item_t * first;
+	unsigned int last_job;
 };
 
 
@@ -39,6 +68,7 @@ struct pidlist_t {
 static inline
 void pidlist_init(struct pidlist_t * pidlist) {
 	pidlist->first = NULL;
+	pidlist->last_job = 0;
 }
 
 static inline
@@ -46,10 +76,13 @@ bool pidlist_empty(struct pidlist_t * pidlist) {
 	return pidlist->first == NULL;
 }
 
-bool pidlist_insert(struct pidlist_t * pidlist, pid_t pid);
+struct pidlist_item_t * pidlist_insert(struct pidlist_t * pidlist, pid_t pid);
 struct pidlist_item_t * pidlist_find(struct pidlist_t * pidlist, pid_t pid);
+struct pidlist_item_t * pidlist_find_job(struct pidlist_t * pidlist, unsigned int job);
 bool pidlist_remove(struct pidlist_t * pidlist, struct pidlist_item_t * item);
 void pidlist_kill_free(struct pidlist_t * pidlist);
+void pidlist_drain(struct pidlist_t * pidlist, int grace_ms,
+						pidlist_kill_cb_t on_kill, struct pidlist_drain_t * res);
 
 #endif // PIDLIST_H_
 
@@ -0,0 +1,343 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 11:03:02 PM
+ *
+ ***********************************************************************
+ */
+
+#include "place.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include "pidlist.h"
+
+/*
+ * Maximum number of NUMA nodes handled
+ */
+#define PLACE_MAX_NODES		64
+
+static const char * NODE_CPULIST		= "/sys/devices/system/node/node%d/cpulist";
+
+static const char * POLICY_NAMES[] = {
+	[PLACE_NONE]		= "none",
+	[PLACE_RR]			= "rr",
+	[PLACE_PACK]		= "pack",
+	[PLACE_SPREAD]		= "spread",
+};
+
+static enum place_policy_t place_policy = PLACE_NONE;
+
+/*
+ * CPUs the shell may run on and NUMA nodes restricted to them
+ */
+static cpu_set_t place_allowed;
+static int place_nnodes = 0;
+static int place_node_id[PLACE_MAX_NODES];
+static cpu_set_t place_node_cpus[PLACE_MAX_NODES];
+
+/*
+ * Next CPU for round-robin
+ */
+static unsigned int place_rr = 0;
+
+/**
+ * @brief  Parse CPU list, e.g. "0-3,8,10-11"
+ *
+ * @param set where to store CPUs
+ * @param list list to be parsed
+ *
+ * @return   true on success
+ */
+static
+bool parse_cpulist(cpu_set_t * set, const char * list) {
+	long first, last;
+	char * end;
+
+	CPU_ZERO(set);
+
+	while (*list && *list != '\n') {
+		first = strtol(list, &end, 10);
+		if (end == list || first < 0)
+			return false;
+
+		last = first;
+		if (*end == '-') {
+			list = end + 1;
+			last = strtol(list, &end, 10);
+			if (end == list || last < first)
+				return false;
+		}
+
+		if (last >= CPU_SETSIZE)
+			return false;
+
+		for (; first <= last; ++first)
+			CPU_SET(first, set);
+
+		if (*end == ',')
+			++end;
+		else if (*end && *end != '\n')
+			return false;
+
+		list = end;
+	}
+
+	return CPU_COUNT(set) > 0;
+}
+
+/**
+ * @brief  Find NUMA node containing all the CPUs
+ *
+ * @param set CPUs to look for
+ *
+ * @return   node or PLACE_NO_NODE
+ */
+static
+int node_of(const cpu_set_t * set) {
+	cpu_set_t and;
+
+	for (int i = 0; i < place_nnodes; ++i) {
+		CPU_AND(&and, set, &place_node_cpus[i]);
+		if (CPU_EQUAL(&and, set))
+			return place_node_id[i];
+	}
+
+	return PLACE_NO_NODE;
+}
+
+/**
+ * @brief  Read NUMA topology, has to be called before other functions
+ *
+ * @return   true on success
+ */
+bool place_topology_init() {
+	char path[64];
+	char buf[1024];
+	cpu_set_t cpus;
+	size_t len;
+	FILE * f;
+
+	if (sched_getaffinity(0, sizeof(place_allowed), &place_allowed) < 0) {
+		perror("sched_getaffinity");
+		return false;
+	}
+
+	place_nnodes = 0;
+	for (int node = 0; node < PLACE_MAX_NODES; ++node) {
+		snprintf(path, sizeof(path), NODE_CPULIST, node);
+		if (! (f = fopen(path, "r")))
+			continue;
+
+		len = fread(buf, 1, sizeof(buf) - 1, f);
+		buf[len] = '\0';
+		fclose(f);
+
+		if (! parse_cpulist(&cpus, buf))
+			continue;
+
+		CPU_AND(&place_node_cpus[place_nnodes], &cpus, &place_allowed);
+		if (CPU_COUNT(&place_node_cpus[place_nnodes]) > 0)
+			place_node_id[place_nnodes++] = node;
+	}
+
+	// no NUMA information, one node with everything
+	if (place_nnodes == 0) {
+		place_node_id[0] = PLACE_NO_NODE;
+		CPU_OR(&place_node_cpus[0], &place_allowed, &place_allowed);
+		place_nnodes = 1;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Parse placement given by PLACE_PREFIX
+ *
+ * CPUs the shell may not run on are refused once place_topology_init() read
+ * them.
+ *
+ * @param place where to store placement
+ * @param list CPU list
+ *
+ * @return   true on success
+ */
+bool place_parse(struct place_t * place, const char * list) {
+	cpu_set_t cpus, and;
+
+	if (! parse_cpulist(&cpus, list))
+		return false;
+
+	// the job could not run on them, sched_setaffinity() would fail in the child
+	CPU_AND(&and, &cpus, &place_allowed);
+	if (place_nnodes > 0 && ! CPU_EQUAL(&and, &cpus))
+		return false;
+
+	place->cpus = cpus;
+	place->node = node_of(&place->cpus);
+	place->set = true;
+
+	return true;
+}
+
+/**
+ * @brief  Set shell wide placement policy
+ *
+ * @param name one of "none", "rr", "pack", "spread"
+ *
+ * @return   true on success
+ */
+bool place_set_policy(const char * name) {
+	for (size_t i = 0; i < sizeof(POLICY_NAMES) / sizeof(POLICY_NAMES[0]); ++i) {
+		if (! strcmp(name, POLICY_NAMES[i])) {
+			place_policy = (enum place_policy_t) i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief  Get name of current placement policy
+ *
+ * @return   policy name
+ */
+const char * place_policy_name() {
+	return POLICY_NAMES[place_policy];
+}
+
+/**
+ * @brief  Choose placement of a new job according to policy
+ *
+ * Explicitly placed jobs are kept as they are.
+ *
+ * @param place placement to fill in
+ * @param jobs jobs running in background, may be NULL
+ */
+void place_next(struct place_t * place, const struct pidlist_t * jobs) {
+	unsigned int count[PLACE_MAX_NODES] = { 0 };
+	const struct pidlist_item_t * it;
+	int best = 0;
+	int i, cpu;
+
+	if (place->set || place_policy == PLACE_NONE)
+		return;
+
+	if (place_policy == PLACE_RR) {
+		for (i = 0, cpu = -1; i < CPU_SETSIZE; ++i) {
+			cpu = (place_rr + i) % CPU_SETSIZE;
+			if (CPU_ISSET(cpu, &place_allowed))
+				break;
+		}
+
+		place_rr = cpu + 1;
+		CPU_ZERO(&place->cpus);
+		CPU_SET(cpu, &place->cpus);
+		place->node = node_of(&place->cpus);
+		place->set = true;
+		return;
+	}
+
+	for (it = jobs ? jobs->first : NULL; it; it = it->next) {
+		for (i = 0; i < place_nnodes; ++i) {
+			if (it->place.set && place_node_id[i] == it->place.node) {
+				count[i]++;
+				break;
+			}
+		}
+	}
+
+	for (i = 0; i < place_nnodes; ++i) {
+		if (place_policy == PLACE_PACK
+				&& count[i] < (unsigned int) CPU_COUNT(&place_node_cpus[i])) {
+			best = i; // first node with a free CPU
+			break;
+		}
+
+		// least jobs per CPU
+		if (count[i] * CPU_COUNT(&place_node_cpus[best])
+				< count[best] * CPU_COUNT(&place_node_cpus[i]))
+			best = i;
+	}
+
+	CPU_OR(&place->cpus, &place_node_cpus[best], &place_node_cpus[best]);
+	place->node = place_node_id[best];
+	place->set = true;
+}
+
+/**
+ * @brief  Apply placement, called in child only
+ *
+ * @param place placement to apply
+ *
+ * @return   true on success
+ */
+bool place_apply(const struct place_t * place) {
+	unsigned long nodemask;
+
+	if (! place->set)
+		return true;
+
+	if (sched_setaffinity(0, sizeof(place->cpus), &place->cpus) < 0) {
+		perror("sched_setaffinity");
+		return false;
+	}
+
+	// prefer memory of the node, ignored by kernels without NUMA
+	if (place->node != PLACE_NO_NODE) {
+		nodemask = 1UL << place->node;
+		syscall(SYS_set_mempolicy, MPOL_PREFERRED, &nodemask,
+				8 * sizeof(nodemask) + 1);
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Format placement for humans, e.g. "cpus=0-3 node=0"
+ *
+ * @param place placement to format
+ * @param buf where to store result
+ * @param len size of buf
+ *
+ * @return   length of the result
+ */
+size_t place_format(const struct place_t * place, char * buf, size_t len) {
+	size_t off = 0;
+	int first, last;
+
+	if (! place->set) {
+		snprintf(buf, len, "-");
+		return strlen(buf);
+	}
+
+	off += snprintf(buf + off, len - off, "cpus=");
+	for (first = 0; first < CPU_SETSIZE && off < len; first = last + 1) {
+		if (! CPU_ISSET(first, &place->cpus)) {
+			last = first;
+			continue;
+		}
+
+		for (last = first; last + 1 < CPU_SETSIZE
+				&& CPU_ISSET(last + 1, &place->cpus); ++last)
+			;
+
+		off += snprintf(buf + off, len - off, "%s%d",
+				buf[off - 1] == '=' ? "" : ",", first);
+		if (last > first && off < len)
+			off += snprintf(buf + off, len - off, "-%d", last);
+	}
+
+	if (place->node != PLACE_NO_NODE && off < len)
+		off += snprintf(buf + off, len - off, " node=%d", place->node);
+
+	return off < len ? off : len - 1;
+}
+
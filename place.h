@@ -0,0 +1,74 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 11:02:44 PM
+ *
+ ***********************************************************************
+ */
+
+#ifndef PLACE_H_
+#define PLACE_H_
+
+#include <sched.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Per job prefix, e.g. @cpus=0-7
+ */
+#define PLACE_PREFIX			"@cpus="
+
+/*
+ * Builtin to set placement policy
+ */
+#define PLACE_CMD				"placement"
+
+/*
+ * Job is not bound to a NUMA node
+ */
+#define PLACE_NO_NODE		(-1)
+
+/**
+ * @brief  Placement of a job
+ */
+struct place_t {
+	bool set;
+	int node;
+	cpu_set_t cpus;
+};
+
+/**
+ * @brief  Shell wide placement policy
+ */
+enum place_policy_t {
+	PLACE_NONE,			// inherit affinity of the shell
+	PLACE_RR,			// one core per job, round-robin
+	PLACE_PACK,			// fill a NUMA node before using the next one
+	PLACE_SPREAD,		// NUMA node with the least jobs
+};
+
+/**
+ * @brief  Init placement, job inherits the shell's placement
+ *
+ * @param place placement to init
+ */
+static inline
+void place_init(struct place_t * place) {
+	place->set = false;
+	place->node = PLACE_NO_NODE;
+	CPU_ZERO(&place->cpus);
+}
+
+struct pidlist_t;
+
+bool place_topology_init();
+bool place_parse(struct place_t * place, const char * list);
+bool place_set_policy(const char * name);
+const char * place_policy_name();
+void place_next(struct place_t * place, const struct pidlist_t * jobs);
+bool place_apply(const struct place_t * place);
+size_t place_format(const struct place_t * place, char * buf, size_t len);
+
+#endif // PLACE_H_
+
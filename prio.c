@@ -0,0 +1,203 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 12:10:45 AM
+ *
+ ***********************************************************************
+ */
+
+#include "prio.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/ioprio.h>
+
+static const char * SCHED_NAMES[] = {
+	[SCHED_OTHER]		= "other",
+	[SCHED_BATCH]		= "batch",
+	[SCHED_IDLE]		= "idle",
+};
+
+static const char * IOCLASS_NAMES[] = {
+	[IOPRIO_CLASS_NONE]	= "none",
+	[IOPRIO_CLASS_BE]		= "be",
+	[IOPRIO_CLASS_IDLE]	= "idle",
+};
+
+/*
+ * Background jobs are demoted so they do not slow down foreground ones
+ */
+static struct prio_t prio_bg = {
+	.set = true,
+	.sched = SCHED_BATCH,
+	.nice = 10,
+	.ioclass = IOPRIO_CLASS_BE,
+	.iolevel = IOPRIO_BE_NR - 1,
+};
+
+/**
+ * @brief  Look up name in a sparse table of names
+ *
+ * @param names table of names
+ * @param count size of table
+ * @param name name to look for
+ *
+ * @return   index or -1 if not found
+ */
+static
+int lookup(const char ** names, size_t count, const char * name) {
+	for (size_t i = 0; i < count; ++i)
+		if (names[i] && ! strcmp(names[i], name))
+			return i;
+
+	return -1;
+}
+
+/**
+ * @brief  Parse priority, e.g. "sched=batch nice=10 io=be:7" or "off"
+ *
+ * Fields not given are kept.
+ *
+ * @param prio priority to update
+ * @param argv NULL terminated vector of fields
+ *
+ * @return   true on success
+ */
+bool prio_parse(struct prio_t * prio, char ** argv) {
+	struct prio_t tmp = *prio;
+	char * end;
+	long val;
+
+	for (; *argv; ++argv) {
+		if (! strcmp(*argv, "off")) {
+			prio_init(&tmp);
+			continue;
+		}
+
+		if (! strncmp(*argv, "sched=", 6)) {
+			val = lookup(SCHED_NAMES, sizeof(SCHED_NAMES) / sizeof(SCHED_NAMES[0]), *argv + 6);
+			if (val < 0)
+				return false;
+			tmp.sched = val;
+		} else if (! strncmp(*argv, "nice=", 5)) {
+			val = strtol(*argv + 5, &end, 10);
+			if (end == *argv + 5 || *end || val < -20 || val > 19)
+				return false;
+			tmp.nice = val;
+		} else if (! strncmp(*argv, "io=", 3)) {
+			if ((end = strchr(*argv + 3, ':')))
+				*end++ = '\0'; // level follows
+
+			val = lookup(IOCLASS_NAMES, sizeof(IOCLASS_NAMES) / sizeof(IOCLASS_NAMES[0]), *argv + 3);
+			if (val < 0)
+				return false;
+			tmp.ioclass = val;
+			tmp.iolevel = val == IOPRIO_CLASS_BE ? IOPRIO_BE_NORM : 0;
+
+			if (end && val == IOPRIO_CLASS_BE) {
+				val = strtol(end, &end, 10);
+				if (*end || val < 0 || val >= IOPRIO_BE_NR)
+					return false;
+				tmp.iolevel = val;
+			}
+		} else {
+			return false;
+		}
+
+		tmp.set = true;
+	}
+
+	*prio = tmp;
+
+	return true;
+}
+
+/**
+ * @brief  Get priority of background jobs
+ *
+ * @return   priority
+ */
+const struct prio_t * prio_background() {
+	return &prio_bg;
+}
+
+/**
+ * @brief  Set priority of background jobs
+ *
+ * @param argv NULL terminated vector of fields, see prio_parse()
+ *
+ * @return   true on success
+ */
+bool prio_set_background(char ** argv) {
+	return prio_parse(&prio_bg, argv);
+}
+
+/**
+ * @brief  Apply priority to a process
+ *
+ * Nice value and scheduling policy are per thread on Linux, a running
+ * multithreaded job has only its main thread re-prioritized.
+ *
+ * @param prio priority to apply
+ * @param pid process to use, 0 for the calling one
+ *
+ * @return   true on success
+ */
+bool prio_apply(const struct prio_t * prio, pid_t pid) {
+	struct sched_param param;
+	bool ret = true;
+
+	if (! prio->set)
+		return true;
+
+	memset(&param, 0, sizeof(param));
+	if (sched_setscheduler(pid, prio->sched, &param) < 0) {
+		perror("sched_setscheduler");
+		ret = false;
+	}
+
+	if (setpriority(PRIO_PROCESS, pid, prio->nice) < 0) {
+		perror("setpriority");
+		ret = false;
+	}
+
+	if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, pid,
+				IOPRIO_PRIO_VALUE(prio->ioclass, prio->iolevel)) < 0) {
+		perror("ioprio_set");
+		ret = false;
+	}
+
+	return ret;
+}
+
+/**
+ * @brief  Format priority for humans, e.g. "sched=batch nice=10 io=be:7"
+ *
+ * @param prio priority to format
+ * @param buf where to store result
+ * @param len size of buf
+ *
+ * @return   length of the result
+ */
+size_t prio_format(const struct prio_t * prio, char * buf, size_t len) {
+	int ret;
+
+	if (! prio->set)
+		ret = snprintf(buf, len, "-");
+	else if (prio->ioclass == IOPRIO_CLASS_BE)
+		ret = snprintf(buf, len, "sched=%s nice=%d io=%s:%d",
+				SCHED_NAMES[prio->sched], prio->nice,
+				IOCLASS_NAMES[prio->ioclass], prio->iolevel);
+	else
+		ret = snprintf(buf, len, "sched=%s nice=%d io=%s",
+				SCHED_NAMES[prio->sched], prio->nice,
+				IOCLASS_NAMES[prio->ioclass]);
+
+	return ret < (int) len ? (size_t) ret : len - 1;
+}
+
@@ -0,0 +1,60 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 12:10:31 AM
+ *
+ ***********************************************************************
+ */
+
+#ifndef PRIO_H_
+#define PRIO_H_
+
+#include <sys/types.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Builtin to set priority of background jobs
+ */
+#define PRIO_BG_CMD			"bgprio"
+
+/*
+ * Builtin to re-prioritize a running job
+ */
+#define PRIO_JOB_CMD			"jobprio"
+
+/**
+ * @brief  CPU and I/O priority of a job
+ */
+struct prio_t {
+	bool set;
+	int sched;			// SCHED_OTHER, SCHED_BATCH or SCHED_IDLE
+	int nice;
+	int ioclass;		// IOPRIO_CLASS_NONE, IOPRIO_CLASS_BE or IOPRIO_CLASS_IDLE
+	int iolevel;
+};
+
+/**
+ * @brief  Init priority, job inherits the shell's priority
+ *
+ * @param prio priority to init
+ */
+static inline
+void prio_init(struct prio_t * prio) {
+	prio->set = false;
+	prio->sched = SCHED_OTHER;
+	prio->nice = 0;
+	prio->ioclass = 0;
+	prio->iolevel = 0;
+}
+
+bool prio_parse(struct prio_t * prio, char ** argv);
+const struct prio_t * prio_background();
+bool prio_set_background(char ** argv);
+bool prio_apply(const struct prio_t * prio, pid_t pid);
+size_t prio_format(const struct prio_t * prio, char * buf, size_t len);
+
+#endif // PRIO_H_
+
@@ -25,20 +25,43 @@
 #include "proj3.h"
 #include "parse.h"
 #include "pidlist.h"
+#include "spawn.h"
+#include "batch.h"
+#include "zygote.h"
+#include "memo.h"
+#include "place.h"
+#include "prio.h"
+#include "deadline.h"
+#include "stats.h"
+#include "timing.h"
+#include "daemon.h"
+#include "agent.h"
+#include "lineedit.h"
+#include "complete.h"
 
 typedef void * (* pthread_fun_t)(void *);
 
 static const char * ROOT_PROMPT			= "# ";
 static const char * USER_PROMPT			= "$ ";
 static const char * CMD_EXIT				= "exit";
+static const char * CMD_JOBS				= "jobs";
 
 static const char * MSG_EXIT				= "\nDone. See you next time, bye!\n";
 static const char * MSG_SIGCHILD			= "\r<<< child %d exited\n";
+static const char * MSG_SIGCHILD_TIMEOUT	= "\r<<< child %d exited, timed out\n";
 static const char * MSG_SIGTERM_CHILD	= "\r<<< some child procs exist, sending SIGTERM\n";
 static const char * MSG_WAIT_CHILD		= "\r<<< waiting for children to be terminated\n";
+static const char * MSG_KILL_CHILD		= "\r<<< child %d (%s) ignored SIGTERM, sending SIGKILL\n";
+static const char * MSG_DRAINED			= "\r<<< %u children drained in %lld ms, %u killed, %u left\n";
 
 static const char * ERR_LONG_INPUT		= "Input too long!\n";
 static const char * ERR_PARSE_FAILED	= "Unable to parse command!\n";
+static const char * ERR_PREFIX			= "Invalid job prefix!\n";
+static const char * ERR_PLACEMENT		= "Unknown placement policy!\n";
+static const char * ERR_PRIO				= "Invalid priority!\n";
+static const char * ERR_NO_JOB			= "No such job!\n";
+static const char * ERR_PRIO_APPLY		= "Unable to re-prioritize the job, it is kept as listed!\n";
+static const char * ERR_DEADLINE		= "Invalid duration!\n";
 
 /**
  * @brief  Stored PIDs of procs run in background
@@ -54,11 +77,21 @@ static volatile bool g_exit = false;
  * buffer for input
  */
 static char buffer[BUF_SIZE];
-pthread_mutex_t buffer_mutex_read;
-pthread_mutex_t buffer_mutex_exec;
+pthread_mutex_t buffer_mutex;
 pthread_cond_t  buffer_cond_read;
 pthread_cond_t  buffer_cond_exec;
 
+/*
+ * buffer holds a line for the executor, protected by buffer_mutex; waiting
+ * on the flag, not on the signal alone, no wakeup can get lost
+ */
+static bool buffer_full = false;
+
+/*
+ * when the reader handed the buffer over, for STATS_HANDOFF
+ */
+static int64_t buffer_ready_ns;
+
 
 /**
  * @brief  Read one char from stdin
@@ -67,12 +100,12 @@ pthread_cond_t  buffer_cond_exec;
  */
 static
 int read_char() {
-	int res;
+	unsigned char res;
 	ssize_t num_read;
 
 	do {
-		num_read = read(1, &res, 1);
-	} while (num_read == EINTR);
+		num_read = read(0, &res, 1);
+	} while (num_read < 0 && errno == EINTR);
 
 	return num_read == 1 ? res : CHAR_EOF;
 }
@@ -89,7 +122,22 @@ int print_help(const char * pname) {
 	UNUSED(pname);
 	static const char * MSG_HELP =
 		"Simple interactive shell implementation using POSIX threads\n"
-		"Fridolin Pokorny, 2014 <fridex.devel@gmail.com>\n";
+		"Fridolin Pokorny, 2014 <fridex.devel@gmail.com>\n"
+		"\n"
+		"Options:\n"
+		"  -z    spawn commands using a fork server\n"
+		"  -g MS grace period for background jobs on exit (default "
+			STR(SHUTDOWN_GRACE_MS) " ms)\n"
+		"  -t DURATION default deadline of jobs, e.g. 30s\n"
+		"  -s FILE dump statistics in Prometheus text format to FILE every "
+			STR(STATS_DUMP_MS) " ms\n"
+		"  -d SOCKET serve commands on a Unix socket instead of stdin\n"
+		"  -w N  number of commands the daemon runs in parallel (default "
+			STR(DAEMON_WORKERS) ")\n"
+		"  -a [HOST:]PORT serve as an agent running dispatched jobs, listens on "
+			DAEMON_TCP_HOST " unless HOST is given\n"
+		"  -R AGENTS run a dispatched job on the first of comma separated agents "
+			"which can run it, used by the " AGENT_CMD " builtin\n";
 
 	write(2, MSG_HELP, strlen(MSG_HELP));
 
@@ -121,24 +169,48 @@ bool print_error(const char * str) {
 void sigchild_handler(int sig) {
 	UNUSED(sig);
 	struct pidlist_item_t * item;
+	struct pidlist_item_t * next;
+	int64_t start = stats_now();
+	int64_t exited;
+	pid_t child_pid;
+	bool timed_out;
 
-	pid_t child_pid = waitpid(-1, NULL, WNOHANG);
-	if ((item = pidlist_find(&pidlist, child_pid))) { // was it running on background?
-		pidlist_remove(&pidlist, item);
-		fprintf(stderr, MSG_SIGCHILD, child_pid);
+	/*
+	 * Reap only procs run in background, foreground ones are waited for
+	 * by their spawner which needs their exit status
+	 */
+	for (item = pidlist.first; item; item = next) {
+		next = item->next;
+		child_pid = item->pid;
+		if (waitpid(child_pid, NULL, WNOHANG) == child_pid) {
+			pidlist_remove(&pidlist, item);
+			free(item);
+
+			// exit not seen by the watchdog yet, it was just before the handler
+			timed_out = deadline_reaped(child_pid, &exited);
+			stats_record(STATS_REAP, stats_now() - (exited ? exited : start));
+			stats_count(STATS_REAPED);
+			fprintf(stderr, timed_out ? MSG_SIGCHILD_TIMEOUT : MSG_SIGCHILD, child_pid);
+		}
 	}
 }
 
+/**
+ * @brief  Get prompt depending on user
+ *
+ * @return   prompt
+ */
+static inline
+const char * prompt() {
+	return geteuid() == 0 ? ROOT_PROMPT : USER_PROMPT;
+}
+
 /**
  * @brief  Print prompt depending on user
  */
 static inline
 void print_prompt() {
-	if (geteuid() == 0) {
-		write(1, ROOT_PROMPT, strlen(ROOT_PROMPT));
-	} else {
-		write(1, USER_PROMPT, strlen(USER_PROMPT));
-	}
+	write(1, prompt(), strlen(prompt()));
 }
 
 /**
@@ -163,6 +235,33 @@ void sigint_unblock() {
 	sigprocmask(SIG_UNBLOCK, &setint, NULL);
 }
 
+/**
+ * @brief  Block SIGTERM signal, daemon_run() reads it using signalfd()
+ */
+static
+void sigterm_block() {
+	sigset_t setterm;
+	sigemptyset(&setterm);
+	sigaddset(&setterm, SIGTERM);
+	sigprocmask(SIG_BLOCK, &setterm, NULL);
+}
+
+/**
+ * @brief  Block or unblock SIGCHLD in the calling thread
+ *
+ * SIGCHLD is blocked everywhere but in the executor while it waits, the
+ * handler then never runs concurrently with code using pidlist or malloc().
+ *
+ * @param block true to block
+ */
+static
+void sigchild_mask(bool block) {
+	sigset_t setchld;
+	sigemptyset(&setchld);
+	sigaddset(&setchld, SIGCHLD);
+	pthread_sigmask(block ? SIG_BLOCK : SIG_UNBLOCK, &setchld, NULL);
+}
+
 /**
  * @brief  Restore signal handlers
  *
@@ -175,7 +274,7 @@ bool signal_handler_restore() {
 	sigemptyset(&sigact.sa_mask);
 	sigact.sa_flags = 0;
 
-	sigact.sa_handler = NULL;
+	sigact.sa_handler = SIG_DFL;
 
 	if (sigaction(SIGCHLD, &sigact, NULL) < 0) {
 		perror("sigaction");
@@ -185,6 +284,16 @@ bool signal_handler_restore() {
 	return true;
 }
 
+/**
+ * @brief  Report background job killed on exit
+ *
+ * @param item job to be killed
+ */
+static
+void print_killed(const struct pidlist_item_t * item) {
+	fprintf(stderr, MSG_KILL_CHILD, item->pid, item->name);
+}
+
 /**
  * @brief  Init signal handlers
  *
@@ -222,9 +331,13 @@ bool read_command() {
 	while (num_read == BUF_SIZE) {
 
 		do {
-			print_prompt();
-			num_read = read(0, buffer, BUF_SIZE);
-		} while (num_read == EINTR); // skip interrupt
+			if (lineedit_enabled()) {
+				num_read = lineedit_read(prompt(), buffer, BUF_SIZE);
+			} else {
+				print_prompt();
+				num_read = read(0, buffer, BUF_SIZE);
+			}
+		} while (num_read < 0 && errno == EINTR); // skip interrupt
 
 		if (num_read == BUF_SIZE) {
 			while (buffer[BUF_SIZE - 1] != '\n'
@@ -253,6 +366,178 @@ bool read_command() {
 	return true;
 }
 
+/**
+ * @brief  Print jobs running in background
+ */
+static
+void print_jobs() {
+	struct pidlist_item_t * it;
+	char place[256];
+	char prio[64];
+
+	for (it = pidlist.first; it; it = it->next) {
+		place_format(&it->place, place, sizeof(place));
+		prio_format(&it->prio, prio, sizeof(prio));
+		printf("[%u] %d %s%s\t%s\t%s\n", it->job, it->pid, it->name,
+				deadline_expired(it->pid) ? " (timed out)" : "", place, prio);
+	}
+
+	fflush(stdout);
+}
+
+/**
+ * @brief  Print default deadline and number of timed out jobs
+ */
+static
+void print_deadline() {
+	if (deadline_default() > 0)
+		printf("%s: %lld ms", DEADLINE_CMD, deadline_default());
+	else
+		printf("%s: off", DEADLINE_CMD);
+
+	printf(", %lu timed out\n", deadline_timed_out());
+	fflush(stdout);
+}
+
+/**
+ * @brief  Re-prioritize running job, argv is "jobprio %job fields..."
+ *
+ * @param argv NULL terminated argument vector
+ *
+ * @return   true on success
+ */
+static
+bool job_prio(char ** argv) {
+	struct pidlist_item_t * item = NULL;
+	struct prio_t prio, apply, undo;
+	char * end;
+	unsigned long job;
+
+	if (argv[1]) {
+		job = strtoul(argv[1] + (argv[1][0] == '%'), &end, 10);
+		if (! *end)
+			item = pidlist_find_job(&pidlist, job);
+	}
+
+	if (! item)
+		return print_error(ERR_NO_JOB);
+
+	prio = item->prio;
+	if (! prio_parse(&prio, &argv[2]))
+		return print_error(ERR_PRIO);
+
+	// "off" has to undo a demotion, so defaults of the shell are applied then
+	apply = prio;
+	apply.set = true;
+	if (! prio_apply(&apply, item->pid)) {
+		undo = item->prio; // back to what is listed, fields applied meanwhile too
+		undo.set = true;
+		prio_apply(&undo, item->pid);
+		return print_error(ERR_PRIO_APPLY);
+	}
+
+	item->prio = prio;
+
+	return true;
+}
+
+/**
+ * @brief  Execute parsed command, builtins included
+ *
+ * @param argv NULL terminated argument vector
+ * @param cmd_list parsed command
+ * @param attr attributes of spawned procs, job prefixes are stored here
+ *
+ * @return   exit status, -1 on error
+ */
+static
+int execute(char ** argv, const struct parse_list_t * cmd_list,
+				struct spawn_attr_t * attr) {
+	pid_t pid;
+
+	attr->timeout_ms = deadline_default();
+
+	// job prefixes
+	if (! (argv = spawn_attr_prefix(attr, argv))) {
+		print_error(ERR_PREFIX);
+		return -1;
+	}
+
+	if (! argv[0])
+		return 0;
+
+	if (! strcmp(argv[0], STATS_CMD)) {
+		stats_print(stdout);
+		return 0;
+	}
+
+	if (! strcmp(argv[0], CMD_JOBS)) {
+		print_jobs();
+		return 0;
+	}
+
+	if (! strcmp(argv[0], PLACE_CMD)) {
+		if (argv[1] && ! place_set_policy(argv[1])) {
+			print_error(ERR_PLACEMENT);
+			return -1;
+		}
+		printf("%s: %s\n", PLACE_CMD, place_policy_name());
+		fflush(stdout);
+		return 0;
+	}
+
+	if (! strcmp(argv[0], PRIO_BG_CMD)) {
+		char prio[64];
+
+		if (! prio_set_background(&argv[1])) {
+			print_error(ERR_PRIO);
+			return -1;
+		}
+		prio_format(prio_background(), prio, sizeof(prio));
+		printf("%s: %s\n", PRIO_BG_CMD, prio);
+		fflush(stdout);
+		return 0;
+	}
+
+	if (! strcmp(argv[0], DEADLINE_CMD)) {
+		long long ms = 0;
+
+		if (argv[1] && strcmp(argv[1], "off") && ! deadline_parse(argv[1], &ms)) {
+			print_error(ERR_DEADLINE);
+			return -1;
+		}
+		if (argv[1])
+			deadline_set_default(ms);
+		print_deadline();
+		return 0;
+	}
+
+	if (! strcmp(argv[0], PRIO_JOB_CMD))
+		return job_prio(argv) ? 0 : -1;
+
+	if (! strcmp(argv[0], BATCH_CMD))
+		return batch_command(argv, attr);
+
+	if (! strcmp(argv[0], TIMING_CMD))
+		return timing_command(argv, attr);
+
+	if (! strcmp(argv[0], MEMO_CMD))
+		return memo_command(argv, cmd_list, attr);
+
+	if (! strcmp(argv[0], AGENT_CMD))
+		return agent_command(argv, attr);
+
+	if (cmd_list->background && agent_registered())
+		pid = agent_spawn(argv, attr);
+	else
+		pid = spawn_command(argv, attr);
+
+	if (pid < 0)
+		return -1;
+
+	return cmd_list->background ? 0 : spawn_wait(pid);
+}
+
 /**
  * @brief  Run command described by string stored in buffer
  *
@@ -264,21 +549,33 @@ static
 void * run_command(void * p) {
 	UNUSED(p);
 	char ** cmd = NULL;
-	int ret;
 	int i = 0;
 	struct parse_list_t cmd_list;
 	struct parse_litem_t * it;
+	struct spawn_attr_t attr;
+	int64_t start;
 
 
-	pthread_mutex_lock(&buffer_mutex_exec);
-	pthread_cond_wait(&buffer_cond_exec, &buffer_mutex_exec);
-	while (! g_exit) {
+	pthread_mutex_lock(&buffer_mutex);
+	for (;;) {
+		sigchild_mask(false); // reap background jobs while idle
+		while (! buffer_full)
+			pthread_cond_wait(&buffer_cond_exec, &buffer_mutex);
+		sigchild_mask(true);
+		if (g_exit) // reader is done
+			break;
+		pthread_mutex_unlock(&buffer_mutex);
+
+		start = stats_now();
+		stats_record(STATS_HANDOFF, start - buffer_ready_ns);
+
 		parse_list_init(&cmd_list);
 
 		if (! parse_command(&cmd_list, buffer)) {
 			print_error(ERR_PARSE_FAILED);
 			goto signalize;
 		}
+		stats_record(STATS_PARSE, stats_now() - start);
 
 		if (cmd_list.length == 1 && ! strcmp(cmd_list.head->token, CMD_EXIT)) {
 			g_exit = true;
@@ -299,76 +596,30 @@ void * run_command(void * p) {
 		}
 		cmd[cmd_list.length] = (char *) 0;
 
-		ret = vfork();
-
-		if (ret < 0) {
-			perror("fork failed");
-		} else if (ret == 0) { // child
-			// open input
-			if (cmd_list.input) {
-				ret = open(cmd_list.input, O_RDONLY);
-				if (ret < 0) {
-					perror(cmd_list.input);
-					exit(EXIT_FAILURE);
-				}
-
-				if (dup2(ret, STDIN_FILENO) < 0) {
-					perror("dup2 STDIN_FILENO");
-					exit(EXIT_FAILURE);
-				}
-			} else if (cmd_list.background) {
-				close(STDIN_FILENO);
-			}
-
-			// open output
-			if (cmd_list.output) {
-				ret = open(cmd_list.output, O_WRONLY | O_CREAT | O_TRUNC, 0666);
-				if (ret < 0) {
-					perror(cmd_list.output);
-					exit(EXIT_FAILURE);
-				}
-
-				if (dup2(ret, STDOUT_FILENO) < 0) {
-					perror("dup2 STDOUT_FILENO");
-					exit(EXIT_FAILURE);
-				}
-			}
+		spawn_attr_init(&attr);
+		if (! spawn_attr_open(&attr, &cmd_list))
+			goto signalize;
+		attr.pidlist = &pidlist;
 
-			/*
-			 * Restore signal handlers
-			 */
-			signal_handler_restore();
+		stats_count(STATS_COMMANDS);
+		execute(cmd, &cmd_list, &attr);
 
-			if (cmd_list.background) {
-				pidlist_insert(&pidlist, getpid());
-				fprintf(stderr, "\r>>> child %d is running in background\n", getpid());
-			} else {
-				// run in foreground, unblock SIGINT
-				sigint_unblock();
-			}
-
-			// run it! :-*
-			ret = execvp(cmd_list.head->token, cmd);
-			if (ret < 0) {
-				perror(cmd_list.head->token);
-				exit(EXIT_FAILURE);
-			}
-		} else { // parent
-			if (! cmd_list.background)
-				waitpid(ret, NULL, 0);
-		}
+		spawn_attr_close(&attr);
 signalize:
 		if (cmd) {
 			free(cmd); cmd = NULL;
 		}
 		parse_free(&cmd_list);
+
+		pthread_mutex_lock(&buffer_mutex);
 		buffer[0] = '\0'; // mark buffer as empty
+		buffer_full = false;
 		pthread_cond_signal(&buffer_cond_read);
-		if (! g_exit) // wait only if no exit signaled
-			pthread_cond_wait(&buffer_cond_exec, &buffer_mutex_exec);
-	} // g_exit
+		if (g_exit)
+			break;
+	}
 
-	pthread_mutex_unlock(&buffer_mutex_exec);
+	pthread_mutex_unlock(&buffer_mutex);
 
 	return NULL;
 }
@@ -383,31 +634,118 @@ signalize:
  */
 int main(int argc, char * argv[]) {
 	pthread_t run_thread;
+	struct pidlist_drain_t drain;
+	bool use_zygote = false;
+	int grace_ms = SHUTDOWN_GRACE_MS;
+	long long deadline_ms;
+	const char * stats_file = NULL;
+	const char * daemon_path = NULL;
+	const char * agent_addr = NULL;
+	const char * agent_list = NULL;
+	const char * builtins[] = { CMD_EXIT, CMD_JOBS, STATS_CMD, PLACE_CMD,
+		PRIO_BG_CMD, PRIO_JOB_CMD, DEADLINE_CMD, BATCH_CMD, TIMING_CMD,
+		MEMO_CMD, AGENT_CMD, NULL };
+	int workers = DAEMON_WORKERS;
+	bool ok;
+	char * end;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "zg:t:s:d:w:a:R:")) != -1) {
+		switch (opt) {
+			case 'z':
+				use_zygote = true;
+				break;
+			case 'g':
+				grace_ms = strtol(optarg, &end, 10);
+				if (*end || grace_ms < 0)
+					return print_help(argv[0]);
+				break;
+			case 't':
+				if (! deadline_parse(optarg, &deadline_ms))
+					return print_help(argv[0]);
+				deadline_set_default(deadline_ms);
+				break;
+			case 's':
+				stats_file = optarg;
+				break;
+			case 'd':
+				daemon_path = optarg;
+				break;
+			case 'w':
+				workers = strtol(optarg, &end, 10);
+				if (*end || workers <= 0)
+					return print_help(argv[0]);
+				break;
+			case 'a':
+				agent_addr = optarg;
+				break;
+			case 'R':
+				agent_list = optarg;
+				break;
+			default:
+				return print_help(argv[0]);
+		}
+	}
 
-	if (argc != 1)
+	// proxy of a dispatched job, nothing else is needed
+	if (agent_list && optind < argc)
+		return agent_remote(agent_list, &argv[optind]);
+
+	if (optind != argc || agent_list)
 		return print_help(argv[0]);
 
-	pthread_mutex_init(&buffer_mutex_read, NULL);
-	pthread_mutex_init(&buffer_mutex_exec, NULL);
+	pthread_mutex_init(&buffer_mutex, NULL);
 	pthread_cond_init (&buffer_cond_read, NULL);
 	pthread_cond_init (&buffer_cond_exec, NULL);
 
 	sigint_block();				// block ^C
+	if (daemon_path || agent_addr)
+		sigterm_block();		// before any thread is created
 	signal_handler_init();		// print info about SIGCHILD
 	pidlist_init(&pidlist);		// init PID list of background procs
+	place_topology_init();		// NUMA nodes for placement policies
+
+	if (use_zygote)				// while still single threaded
+		zygote_start();
+
+	sigchild_mask(true);		// inherited by all threads, see sigchild_mask()
+	deadline_start();			// watchdog of job deadlines
+
+	if (stats_file && ! stats_dump_start(stats_file, STATS_DUMP_MS))
+		return EXIT_FAILURE;
+
+	if (daemon_path || agent_addr) {
+		if (agent_addr)
+			ok = daemon_run_tcp(agent_addr, workers, builtins);
+		else
+			ok = daemon_run(daemon_path, workers, builtins);
+
+		stats_dump_stop();
+		deadline_stop();
+		zygote_stop();
+
+		return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (lineedit_start())		// only at a terminal
+		complete_start(builtins);	// PATH is indexed in background
 
 	pthread_create(&run_thread, NULL, (pthread_fun_t) run_command, NULL);
 
-	pthread_mutex_lock(&buffer_mutex_read);
 	while (! g_exit) {
+		// buffer is ours until handed over
 		if (! read_command())
 			g_exit = true;
 
+		buffer_ready_ns = stats_now();
+
+		pthread_mutex_lock(&buffer_mutex);
+		buffer_full = true;
 		pthread_cond_signal(&buffer_cond_exec);
-		if (! g_exit) // wait only if there is something to do
-			pthread_cond_wait(&buffer_cond_read, &buffer_mutex_read);
+		while (buffer_full && ! g_exit) // wait only if there is something to do
+			pthread_cond_wait(&buffer_cond_read, &buffer_mutex);
+		pthread_mutex_unlock(&buffer_mutex);
 	}
-	pthread_mutex_unlock(&buffer_mutex_read);
 
 	pthread_join(run_thread, NULL);
 
@@ -415,14 +753,20 @@ int main(int argc, char * argv[]) {
 	 * kill remaining procs
 	 */
 	if (! pidlist_empty(&pidlist)) {
+		signal_handler_restore();	// reaped by pidlist_drain() now
 		write(2, MSG_SIGTERM_CHILD, strlen(MSG_SIGTERM_CHILD));
-		pidlist_kill_free(&pidlist);
 		write(2, MSG_WAIT_CHILD, strlen(MSG_WAIT_CHILD));
-		waitpid(-1, NULL, 0);
+		pidlist_drain(&pidlist, grace_ms, print_killed, &drain);
+		fprintf(stderr, MSG_DRAINED, drain.jobs, drain.elapsed_ms,
+				drain.killed, drain.left);
 	}
 
-	pthread_mutex_destroy(&buffer_mutex_read);
-	pthread_mutex_destroy(&buffer_mutex_exec);
+	complete_stop();
+	stats_dump_stop();
+	deadline_stop();
+	zygote_stop();
+
+	pthread_mutex_destroy(&buffer_mutex);
 	pthread_cond_destroy(&buffer_cond_read);
 	pthread_cond_destroy(&buffer_cond_exec);
 
@@ -32,5 +32,20 @@
 # define CHAR_EOF		-1
 #endif // CHAR_EOF
 
+/*
+ * Stringify macro argument
+ */
+#ifndef STR
+# define STR_(X)				#X
+# define STR(X)				STR_(X)
+#endif // STR(X)
+
+/*
+ * How long background jobs may take to exit after SIGTERM on shell exit (ms)
+ */
+#ifndef SHUTDOWN_GRACE_MS
+# define SHUTDOWN_GRACE_MS	2000
+#endif // SHUTDOWN_GRACE_MS
+
 #endif // PROJ3_H_
 
@@ -0,0 +1,354 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 08:02:25 PM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "spawn.h"
+#include "zygote.h"
+#include "deadline.h"
+#include "stats.h"
+
+extern char ** environ;
+
+/**
+ * @brief  Apply job prefixes, e.g. @cpus=0-3 timeout=30s command args
+ *
+ * @param attr attributes to store prefixes to
+ * @param argv NULL terminated argument vector starting with prefixes
+ *
+ * @return   argv past the prefixes or NULL on an invalid prefix
+ */
+char ** spawn_attr_prefix(struct spawn_attr_t * attr, char ** argv) {
+	for (; *argv && ((*argv)[0] == '@'
+				|| ! strncmp(*argv, DEADLINE_PREFIX, strlen(DEADLINE_PREFIX))); ++argv) {
+		if (! strncmp(*argv, PLACE_PREFIX, strlen(PLACE_PREFIX))
+				&& place_parse(&attr->place, *argv + strlen(PLACE_PREFIX)))
+			continue;
+
+		if (! strncmp(*argv, DEADLINE_PREFIX, strlen(DEADLINE_PREFIX))
+				&& deadline_parse(*argv + strlen(DEADLINE_PREFIX), &attr->timeout_ms))
+			continue;
+
+		return NULL;
+	}
+
+	return argv;
+}
+
+/**
+ * @brief  Open a redirection, relative paths are relative to attr->cwd
+ *
+ * @param attr attributes of the command
+ * @param path file to open
+ * @param flags flags of open()
+ *
+ * @return   descriptor or -1 on failure
+ */
+static
+int spawn_open(const struct spawn_attr_t * attr, const char * path, int flags) {
+	char buf[PATH_MAX];
+
+	if (attr->cwd && path[0] != '/') {
+		if (snprintf(buf, sizeof(buf), "%s/%s", attr->cwd, path) >= (int) sizeof(buf)) {
+			errno = ENAMETOOLONG;
+			return -1;
+		}
+		path = buf;
+	}
+
+	return open(path, flags, 0666);
+}
+
+/**
+ * @brief  Open redirections of a parsed command
+ *
+ * @param attr attributes to store opened descriptors to
+ * @param cmd_list parsed command
+ *
+ * @return   true on success, otherwise false (error is reported)
+ */
+bool spawn_attr_open(struct spawn_attr_t * attr,
+							const struct parse_list_t * cmd_list) {
+	attr->background = cmd_list->background;
+
+	// open input
+	if (cmd_list->input) {
+		attr->fd_in = spawn_open(attr, cmd_list->input, O_RDONLY | O_CLOEXEC);
+		if (attr->fd_in < 0) {
+			perror(cmd_list->input);
+			attr->fd_in = SPAWN_FD_INHERIT;
+			return false;
+		}
+	} else if (cmd_list->background) {
+		attr->fd_in = SPAWN_FD_CLOSE;
+	}
+
+	// open output
+	if (cmd_list->output) {
+		attr->fd_out = spawn_open(attr, cmd_list->output,
+				O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC);
+		if (attr->fd_out < 0) {
+			perror(cmd_list->output);
+			attr->fd_out = SPAWN_FD_INHERIT;
+			spawn_attr_close(attr);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Close descriptors opened by spawn_attr_open() or set by caller
+ *
+ * @param attr attributes to use
+ */
+void spawn_attr_close(struct spawn_attr_t * attr) {
+	if (attr->fd_in >= 0)
+		close(attr->fd_in);
+
+	if (attr->fd_out >= 0)
+		close(attr->fd_out);
+
+	if (attr->fd_err >= 0)
+		close(attr->fd_err);
+
+	attr->fd_in = SPAWN_FD_INHERIT;
+	attr->fd_out = SPAWN_FD_INHERIT;
+	attr->fd_err = SPAWN_FD_INHERIT;
+}
+
+/**
+ * @brief  Prepare the child for exec, called in child only
+ *
+ * @param attr attributes to apply
+ *
+ * @return   true on success
+ */
+bool spawn_child_setup(const struct spawn_attr_t * attr) {
+	struct sigaction sigact;
+	sigset_t setint;
+	sigset_t setunblock;
+
+	if (attr->fd_in == SPAWN_FD_CLOSE) {
+		close(STDIN_FILENO);
+	} else if (attr->fd_in >= 0 && dup2(attr->fd_in, STDIN_FILENO) < 0) {
+		perror("dup2 STDIN_FILENO");
+		return false;
+	}
+
+	if (attr->fd_out == SPAWN_FD_CLOSE) {
+		close(STDOUT_FILENO);
+	} else if (attr->fd_out >= 0 && dup2(attr->fd_out, STDOUT_FILENO) < 0) {
+		perror("dup2 STDOUT_FILENO");
+		return false;
+	}
+
+	if (attr->fd_err >= 0 && dup2(attr->fd_err, STDERR_FILENO) < 0) {
+		perror("dup2 STDERR_FILENO");
+		return false;
+	}
+
+	if (attr->cwd && chdir(attr->cwd) < 0) {
+		perror(attr->cwd);
+		return false;
+	}
+
+	/*
+	 * Restore signal handlers
+	 */
+	sigemptyset(&sigact.sa_mask);
+	sigact.sa_flags = 0;
+	sigact.sa_handler = SIG_DFL;
+	sigaction(SIGCHLD, &sigact, NULL);
+
+	// the shell blocks them in all threads, see sigchild_mask(), daemon_run()
+	sigemptyset(&setunblock);
+	sigaddset(&setunblock, SIGCHLD);
+	sigaddset(&setunblock, SIGTERM);
+	sigprocmask(SIG_UNBLOCK, &setunblock, NULL);
+
+	if (! place_apply(&attr->place))
+		return false;
+
+	// a failed demotion is reported, but the command still runs
+	prio_apply(&attr->prio, 0);
+
+	if (attr->background) {
+		fprintf(stderr, "\r>>> child %d is running in background\n", getpid());
+	} else {
+		// run in foreground, unblock SIGINT
+		sigemptyset(&setint);
+		sigaddset(&setint, SIGINT);
+		sigprocmask(SIG_UNBLOCK, &setint, NULL);
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Register background job
+ *
+ * @param argv command of the job
+ * @param attr attributes of the job
+ * @param pid PID of the job
+ */
+static
+void spawn_register(char ** argv, const struct spawn_attr_t * attr, pid_t pid) {
+	struct pidlist_item_t * item;
+
+	if (! attr->background || ! attr->pidlist)
+		return;
+
+	if ((item = pidlist_insert(attr->pidlist, pid))) {
+		snprintf(item->name, sizeof(item->name), "%s", argv[0]);
+		item->place = attr->place;
+		item->prio = attr->prio;
+	}
+}
+
+/**
+ * @brief  Spawn a command using vfork()
+ *
+ * @param argv NULL terminated argument vector
+ * @param child attributes of the new process
+ *
+ * @return   PID of the child or -1 on failure
+ */
+static
+pid_t spawn_vfork(char ** argv, struct spawn_attr_t * child) {
+	pid_t pid;
+
+	pid = vfork();
+
+	if (pid < 0) {
+		perror("fork failed");
+	} else if (pid == 0) { // child
+		// parent is suspended until exec, register before it can exit
+		spawn_register(argv, child, getpid());
+
+		if (! spawn_child_setup(child))
+			_exit(EXIT_FAILURE);
+
+		// run it! :-* (PATH of the shell is searched)
+		execvpe(argv[0], argv, child->envp ? child->envp : environ);
+		perror(argv[0]);
+		_exit(127);
+	}
+
+	return pid;
+}
+
+/**
+ * @brief  Spawn a command
+ *
+ * @param argv NULL terminated argument vector, argv[0] is looked up in PATH
+ * @param attr attributes of the new process
+ *
+ * @return   PID of the child or -1 on failure
+ */
+pid_t spawn_command(char ** argv, const struct spawn_attr_t * attr) {
+	struct spawn_attr_t child = *attr;
+	int64_t start;
+	int pidfd = -1;
+	pid_t pid = -1;
+
+	place_next(&child.place, attr->pidlist);
+	if (attr->background && ! child.prio.set)
+		child.prio = *prio_background();
+
+	start = stats_now();
+
+	if (zygote_running()) {
+		pid = zygote_spawn(argv, &child, &pidfd);
+
+		if (pid > 0 && attr->background && attr->pidlist) {
+			spawn_register(argv, &child, pid);
+			kill(getpid(), SIGCHLD); // rescan, the child may be gone already
+		}
+	}
+
+	// fork server is not used or it is gone, then this command runs anyway
+	if (! zygote_running())
+		pid = spawn_vfork(argv, &child);
+
+	// vfork() parent resumes once the child has exec'd
+	stats_record(STATS_SPAWN, stats_now() - start);
+	stats_count(pid > 0 ? STATS_SPAWNED : STATS_SPAWN_FAILED);
+
+	// background jobs also to know when they exit, see STATS_REAP
+	if (pid > 0 && (attr->timeout_ms > 0 || attr->background))
+		deadline_watch(pid, pidfd, attr->timeout_ms); // takes pidfd over
+	else if (pidfd >= 0)
+		close(pidfd);
+
+	return pid;
+}
+
+/**
+ * @brief  Wait for a child to finish
+ *
+ * @param pid PID of the child
+ *
+ * @return   exit status, 128 + signal number if killed, DEADLINE_STATUS if
+ *           it timed out, -1 on error
+ */
+int spawn_wait(pid_t pid) {
+	return spawn_wait_rusage(pid, NULL);
+}
+
+/**
+ * @brief  Wait for a child to finish and get its resource usage
+ *
+ * @param pid PID of the child
+ * @param ru where to store resource usage, may be NULL
+ *
+ * @return   exit status, 128 + signal number if killed, DEADLINE_STATUS if
+ *           it timed out, -1 on error
+ */
+int spawn_wait_rusage(pid_t pid, struct rusage * ru) {
+	int64_t start = stats_now();
+	sigset_t setchld, old;
+	int status;
+	int ret;
+
+	// background jobs are reaped by the SIGCHLD handler meanwhile
+	sigemptyset(&setchld);
+	sigaddset(&setchld, SIGCHLD);
+	pthread_sigmask(SIG_UNBLOCK, &setchld, &old);
+
+	while ((ret = wait4(pid, &status, 0, ru)) < 0 && errno == EINTR)
+		;
+
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	if (ret < 0)
+		return -1;
+
+	stats_record(STATS_WAIT, stats_now() - start);
+
+	if (deadline_reaped(pid, NULL))
+		return DEADLINE_STATUS;
+
+	if (WIFSIGNALED(status))
+		return 128 + WTERMSIG(status);
+
+	return WEXITSTATUS(status);
+}
+
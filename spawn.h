@@ -0,0 +1,77 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 08:02:11 PM
+ *
+ ***********************************************************************
+ */
+
+#ifndef SPAWN_H_
+#define SPAWN_H_
+
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <stdbool.h>
+
+#include "parse.h"
+#include "pidlist.h"
+#include "place.h"
+#include "prio.h"
+
+/*
+ * Special values of spawn_attr_t.fd_in and spawn_attr_t.fd_out
+ */
+#define SPAWN_FD_INHERIT		(-1)
+#define SPAWN_FD_CLOSE			(-2)
+
+/**
+ * @brief  Attributes of a spawned process
+ */
+struct spawn_attr_t {
+	int fd_in;
+	int fd_out;
+	int fd_err;
+	bool background;
+	struct place_t place;
+	struct prio_t prio;
+	long long timeout_ms;		// deadline, 0 if none
+	const char * cwd;				// working directory, NULL to inherit
+	char ** envp;					// environment, NULL to inherit
+
+	/*
+	 * background child registers itself here before exec
+	 */
+	struct pidlist_t * pidlist;
+};
+
+/**
+ * @brief  Init spawn attributes
+ *
+ * @param attr attributes to init
+ */
+static inline
+void spawn_attr_init(struct spawn_attr_t * attr) {
+	attr->fd_in = SPAWN_FD_INHERIT;
+	attr->fd_out = SPAWN_FD_INHERIT;
+	attr->fd_err = SPAWN_FD_INHERIT;
+	attr->background = false;
+	place_init(&attr->place);
+	prio_init(&attr->prio);
+	attr->timeout_ms = 0;
+	attr->cwd = NULL;
+	attr->envp = NULL;
+	attr->pidlist = NULL;
+}
+
+char ** spawn_attr_prefix(struct spawn_attr_t * attr, char ** argv);
+bool spawn_attr_open(struct spawn_attr_t * attr,
+							const struct parse_list_t * cmd_list);
+void spawn_attr_close(struct spawn_attr_t * attr);
+bool spawn_child_setup(const struct spawn_attr_t * attr);
+pid_t spawn_command(char ** argv, const struct spawn_attr_t * attr);
+int spawn_wait(pid_t pid);
+int spawn_wait_rusage(pid_t pid, struct rusage * ru);
+
+#endif // SPAWN_H_
+
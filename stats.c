@@ -0,0 +1,448 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 02:48:36 AM
+ *
+ ***********************************************************************
+ */
+
+#include "stats.h"
+
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+#include <errno.h>
+
+#include "daemon.h"
+
+/*
+ * Samples are kept in log-linear histograms (HDR-style): values below
+ * 2^STATS_SUB_BITS ns are exact, above that each power of two is split into
+ * 2^STATS_SUB_BITS buckets, i.e. relative error is below 1 / 2^STATS_SUB_BITS.
+ * Every thread records into its own slot (see STATS_MAX_SLOTS) using relaxed
+ * atomics, no locks are taken and the SIGCHLD handler may record too. Slots
+ * are merged on read.
+ */
+#define STATS_SUB_BITS		4
+#define STATS_SUB				(1 << STATS_SUB_BITS)
+#define STATS_MAX_BITS		40			// ~18 minutes in ns
+#define STATS_NBUCKETS		((STATS_MAX_BITS - STATS_SUB_BITS + 1) * STATS_SUB)
+
+/*
+ * Maximum number of recording threads: workers of the daemon plus reader,
+ * executor, deadline watchdog and dump threads with some headroom. Threads
+ * past it (e.g. proj3 -w more than DAEMON_WORKERS) share the last slot,
+ * counts stay right but they contend for it.
+ */
+#define STATS_MAX_SLOTS		(DAEMON_WORKERS + 8)
+
+static const char * STAGE_NAMES[] = {
+	[STATS_HANDOFF]	= "handoff",
+	[STATS_PARSE]		= "parse",
+	[STATS_SPAWN]		= "spawn",
+	[STATS_WAIT]		= "wait",
+	[STATS_REAP]		= "reap",
+};
+
+static const char * COUNTER_NAMES[] = {
+	[STATS_COMMANDS]		= "commands",
+	[STATS_SPAWNED]		= "spawned",
+	[STATS_SPAWN_FAILED]	= "spawn_failed",
+	[STATS_REAPED]			= "reaped",
+};
+
+static const double QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+#define NQUANTILES			(sizeof(QUANTILES) / sizeof(QUANTILES[0]))
+
+/**
+ * @brief  Histogram of one stage
+ */
+struct stats_hist_t {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint64_t buckets[STATS_NBUCKETS];
+};
+
+/**
+ * @brief  Per thread statistics
+ */
+struct stats_slot_t {
+	struct stats_hist_t hist[STATS_NSTAGES];
+	uint64_t counters[STATS_NCOUNTERS];
+} __attribute__((aligned(64)));
+
+static struct stats_slot_t stats_slots[STATS_MAX_SLOTS];
+static unsigned int stats_nslots = 0;
+static __thread struct stats_slot_t * stats_slot = NULL;
+
+/*
+ * Periodic dump
+ */
+static pthread_t stats_dump_thread;
+static pthread_mutex_t stats_dump_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stats_dump_cond;
+static bool stats_dump_running = false;
+static bool stats_dump_exit = false;
+static char * stats_dump_path = NULL;
+static long stats_dump_ms = STATS_DUMP_MS;
+
+/**
+ * @brief  Get slot of the calling thread, async-signal-safe
+ *
+ * @return   slot to record into
+ */
+static inline
+struct stats_slot_t * slot_get() {
+	unsigned int i;
+
+	if (! stats_slot) {
+		i = __atomic_fetch_add(&stats_nslots, 1, __ATOMIC_RELAXED);
+		stats_slot = &stats_slots[i < STATS_MAX_SLOTS ? i : STATS_MAX_SLOTS - 1];
+	}
+
+	return stats_slot;
+}
+
+/**
+ * @brief  Map value to histogram bucket
+ *
+ * @param ns value
+ *
+ * @return   bucket index
+ */
+static inline
+unsigned int bucket_of(uint64_t ns) {
+	unsigned int e;
+
+	if (ns < STATS_SUB)
+		return ns;
+
+	if (ns >> STATS_MAX_BITS)
+		return STATS_NBUCKETS - 1;
+
+	e = 63 - __builtin_clzll(ns);
+
+	return (e - STATS_SUB_BITS + 1) * STATS_SUB
+		+ ((ns >> (e - STATS_SUB_BITS)) & (STATS_SUB - 1));
+}
+
+/**
+ * @brief  Get middle of a histogram bucket
+ *
+ * @param i bucket index
+ *
+ * @return   value representing the bucket
+ */
+static
+uint64_t bucket_value(unsigned int i) {
+	unsigned int e;
+
+	if (i < STATS_SUB)
+		return i;
+
+	e = i / STATS_SUB + STATS_SUB_BITS - 1;
+
+	return ((uint64_t) (STATS_SUB + i % STATS_SUB) << (e - STATS_SUB_BITS))
+		+ ((1ULL << (e - STATS_SUB_BITS)) >> 1);
+}
+
+/**
+ * @brief  Record duration of a stage
+ *
+ * @param stage measured stage
+ * @param ns duration in nanoseconds
+ */
+void stats_record(enum stats_stage_t stage, int64_t ns) {
+	struct stats_hist_t * hist = &slot_get()->hist[stage];
+	uint64_t v = ns > 0 ? ns : 0;
+	uint64_t max;
+
+	__atomic_add_fetch(&hist->buckets[bucket_of(v)], 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&hist->sum, v, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&hist->count, 1, __ATOMIC_RELAXED);
+
+	max = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+	while (v > max && ! __atomic_compare_exchange_n(&hist->max, &max, v,
+				true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+}
+
+/**
+ * @brief  Count an event
+ *
+ * @param counter event to count
+ */
+void stats_count(enum stats_counter_t counter) {
+	__atomic_add_fetch(&slot_get()->counters[counter], 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief  Merge histograms of a stage from all threads
+ *
+ * @param stage stage to merge
+ * @param hist where to store result
+ */
+static
+void merge_hist(enum stats_stage_t stage, struct stats_hist_t * hist) {
+	const struct stats_hist_t * src;
+	uint64_t max;
+
+	memset(hist, 0, sizeof(*hist));
+
+	for (unsigned int s = 0; s < STATS_MAX_SLOTS; ++s) {
+		src = &stats_slots[s].hist[stage];
+		for (unsigned int i = 0; i < STATS_NBUCKETS; ++i)
+			hist->buckets[i] += __atomic_load_n(&src->buckets[i], __ATOMIC_RELAXED);
+		hist->sum += __atomic_load_n(&src->sum, __ATOMIC_RELAXED);
+		max = __atomic_load_n(&src->max, __ATOMIC_RELAXED);
+		if (max > hist->max)
+			hist->max = max;
+	}
+
+	// count from buckets, consistent with quantiles
+	for (unsigned int i = 0; i < STATS_NBUCKETS; ++i)
+		hist->count += hist->buckets[i];
+}
+
+/**
+ * @brief  Sum counter of all threads
+ *
+ * @param counter counter to sum
+ *
+ * @return   sum
+ */
+static
+uint64_t merge_counter(enum stats_counter_t counter) {
+	uint64_t sum = 0;
+
+	for (unsigned int s = 0; s < STATS_MAX_SLOTS; ++s)
+		sum += __atomic_load_n(&stats_slots[s].counters[counter], __ATOMIC_RELAXED);
+
+	return sum;
+}
+
+/**
+ * @brief  Get quantile of a histogram
+ *
+ * @param hist merged histogram
+ * @param q quantile, 0 to 1
+ *
+ * @return   value in nanoseconds
+ */
+static
+uint64_t hist_quantile(const struct stats_hist_t * hist, double q) {
+	uint64_t rank, seen = 0;
+	uint64_t v;
+
+	if (! hist->count)
+		return 0;
+
+	rank = (uint64_t) (q * hist->count);
+	if (rank >= hist->count)
+		rank = hist->count - 1;
+
+	for (unsigned int i = 0; i < STATS_NBUCKETS; ++i) {
+		seen += hist->buckets[i];
+		if (seen > rank) {
+			v = bucket_value(i);
+			return v < hist->max ? v : hist->max;
+		}
+	}
+
+	return hist->max;
+}
+
+/**
+ * @brief  Print statistics for humans, times are in microseconds
+ *
+ * @param f where to print
+ */
+void stats_print(FILE * f) {
+	struct stats_hist_t hist;
+
+	fprintf(f, "%-8s %10s %10s", "stage", "count", "mean_us");
+	for (size_t q = 0; q < NQUANTILES; ++q)
+		fprintf(f, " %9g%%", QUANTILES[q] * 100);
+	fprintf(f, " %10s\n", "max_us");
+
+	for (int s = 0; s < STATS_NSTAGES; ++s) {
+		merge_hist((enum stats_stage_t) s, &hist);
+		fprintf(f, "%-8s %10llu %10.1f", STAGE_NAMES[s],
+				(unsigned long long) hist.count,
+				hist.count ? hist.sum / 1000.0 / hist.count : 0.0);
+		for (size_t q = 0; q < NQUANTILES; ++q)
+			fprintf(f, " %10.1f", hist_quantile(&hist, QUANTILES[q]) / 1000.0);
+		fprintf(f, " %10.1f\n", hist.max / 1000.0);
+	}
+
+	for (int c = 0; c < STATS_NCOUNTERS; ++c)
+		fprintf(f, "%s%s %llu", c ? ", " : "", COUNTER_NAMES[c],
+				(unsigned long long) merge_counter((enum stats_counter_t) c));
+	fprintf(f, "\n");
+	fflush(f);
+}
+
+/**
+ * @brief  Write statistics in Prometheus text format
+ *
+ * @param f where to write
+ *
+ * @return   true on success
+ */
+bool stats_prometheus(FILE * f) {
+	struct stats_hist_t hist;
+
+	fprintf(f, "# HELP proj3_stage_seconds Latency of command stages.\n"
+			"# TYPE proj3_stage_seconds summary\n");
+
+	for (int s = 0; s < STATS_NSTAGES; ++s) {
+		merge_hist((enum stats_stage_t) s, &hist);
+		for (size_t q = 0; q < NQUANTILES; ++q)
+			fprintf(f, "proj3_stage_seconds{stage=\"%s\",quantile=\"%g\"} %.9f\n",
+					STAGE_NAMES[s], QUANTILES[q], hist_quantile(&hist, QUANTILES[q]) / 1e9);
+		fprintf(f, "proj3_stage_seconds_sum{stage=\"%s\"} %.9f\n",
+				STAGE_NAMES[s], hist.sum / 1e9);
+		fprintf(f, "proj3_stage_seconds_count{stage=\"%s\"} %llu\n",
+				STAGE_NAMES[s], (unsigned long long) hist.count);
+	}
+
+	for (int c = 0; c < STATS_NCOUNTERS; ++c)
+		fprintf(f, "# TYPE proj3_%s_total counter\nproj3_%s_total %llu\n",
+				COUNTER_NAMES[c], COUNTER_NAMES[c],
+				(unsigned long long) merge_counter((enum stats_counter_t) c));
+
+	return ! ferror(f);
+}
+
+/**
+ * @brief  Dump statistics to stats_dump_path, replaced atomically
+ *
+ * @return   true on success
+ */
+static
+bool dump_file() {
+	char tmp[PATH_MAX];
+	bool ok;
+	FILE * f;
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", stats_dump_path);
+	if (! (f = fopen(tmp, "we")))
+		return false;
+
+	ok = stats_prometheus(f);
+	if (fclose(f) != 0 || ! ok || rename(tmp, stats_dump_path) < 0) {
+		unlink(tmp);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  Dumping thread
+ *
+ * @param p unused
+ *
+ * @return   NULL
+ */
+static
+void * dump_run(void * p) {
+	struct timespec ts;
+	sigset_t setchld;
+
+	(void) p;
+
+	// SIGCHLD is handled by other threads
+	sigemptyset(&setchld);
+	sigaddset(&setchld, SIGCHLD);
+	pthread_sigmask(SIG_BLOCK, &setchld, NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	pthread_mutex_lock(&stats_dump_mutex);
+	while (! stats_dump_exit) {
+		ts.tv_sec += stats_dump_ms / 1000;
+		ts.tv_nsec += (stats_dump_ms % 1000) * 1000000;
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+
+		while (! stats_dump_exit
+				&& pthread_cond_timedwait(&stats_dump_cond, &stats_dump_mutex, &ts) != ETIMEDOUT)
+			;
+
+		dump_file(); // final one on exit too
+	}
+	pthread_mutex_unlock(&stats_dump_mutex);
+
+	return NULL;
+}
+
+/**
+ * @brief  Start dumping statistics to a file periodically
+ *
+ * @param path file to write, e.g. for node_exporter textfile collector
+ * @param interval_ms period of dumps
+ *
+ * @return   true on success
+ */
+bool stats_dump_start(const char * path, long interval_ms) {
+	pthread_condattr_t attr;
+
+	if (stats_dump_running || interval_ms <= 0)
+		return false;
+
+	stats_dump_path = strdup(path);
+	stats_dump_ms = interval_ms;
+	stats_dump_exit = false;
+
+	if (! stats_dump_path || ! dump_file()) {
+		perror(path);
+		free(stats_dump_path);
+		stats_dump_path = NULL;
+		return false;
+	}
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&stats_dump_cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	if (pthread_create(&stats_dump_thread, NULL, dump_run, NULL) != 0) {
+		pthread_cond_destroy(&stats_dump_cond);
+		free(stats_dump_path);
+		stats_dump_path = NULL;
+		return false;
+	}
+
+	stats_dump_running = true;
+
+	return true;
+}
+
+/**
+ * @brief  Stop dumping statistics, the file is written one last time
+ */
+void stats_dump_stop() {
+	if (! stats_dump_running)
+		return;
+
+	pthread_mutex_lock(&stats_dump_mutex);
+	stats_dump_exit = true;
+	pthread_cond_signal(&stats_dump_cond);
+	pthread_mutex_unlock(&stats_dump_mutex);
+
+	pthread_join(stats_dump_thread, NULL);
+	pthread_cond_destroy(&stats_dump_cond);
+
+	free(stats_dump_path);
+	stats_dump_path = NULL;
+	stats_dump_running = false;
+}
+
@@ -0,0 +1,76 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 02:48:10 AM
+ *
+ ***********************************************************************
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+/*
+ * Builtin to print statistics
+ */
+#define STATS_CMD				"stats"
+
+/*
+ * Period of dumps to a file (ms)
+ */
+#ifndef STATS_DUMP_MS
+# define STATS_DUMP_MS		10000
+#endif // STATS_DUMP_MS
+
+/**
+ * @brief  Measured stages of a command
+ */
+enum stats_stage_t {
+	STATS_HANDOFF,			// line read (or daemon request received) until executor
+								// (or daemon worker) picked it up
+	STATS_PARSE,			// parse_command()
+	STATS_SPAWN,			// spawn until exec, parent is suspended meanwhile
+	STATS_WAIT,				// waiting for a foreground job
+	STATS_REAP,				// background job exited (its pidfd became readable)
+								// until reaped
+	STATS_NSTAGES,
+};
+
+/**
+ * @brief  Counted events
+ */
+enum stats_counter_t {
+	STATS_COMMANDS,		// command lines executed
+	STATS_SPAWNED,			// processes spawned
+	STATS_SPAWN_FAILED,	// spawns failed
+	STATS_REAPED,			// background jobs reaped
+	STATS_NCOUNTERS,
+};
+
+/**
+ * @brief  Current time for measurements
+ *
+ * @return   monotonic time in nanoseconds
+ */
+static inline
+int64_t stats_now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void stats_record(enum stats_stage_t stage, int64_t ns);
+void stats_count(enum stats_counter_t counter);
+void stats_print(FILE * f);
+bool stats_prometheus(FILE * f);
+bool stats_dump_start(const char * path, long interval_ms);
+void stats_dump_stop();
+
+#endif // STATS_H_
+
@@ -0,0 +1,398 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 05:13:20 AM
+ *
+ ***********************************************************************
+ */
+
+#include "timing.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <math.h>
+#include <sys/resource.h>
+
+#include "stats.h"
+
+static const char * ERR_TIMING_USAGE		=
+	"Usage: " TIMING_CMD " [-n runs] [-w warmup] [-j] cmd args [" TIMING_SEP " cmd args]...\n";
+static const char * ERR_TIMING_BACKGROUND	= "bench: cannot run in background!\n";
+static const char * ERR_TIMING_SPAWN		= "bench: unable to run command!\n";
+static const char * ERR_TIMING_INTERRUPT	= "bench: interrupted!\n";
+
+/**
+ * @brief  Measurements of one command
+ */
+struct timing_t {
+	char ** argv;
+	long long * wall;			// ns per run
+	long long user;			// ns, sum of all runs
+	long long sys;				// ns, sum of all runs
+	long maxrss;				// KiB, maximum of all runs
+	int failed;					// runs with non-zero exit status
+	int runs;
+
+	// summary, computed by timing_summarize()
+	double mean, stddev;
+	long long min, p50, p95, p99, max;
+	int low, high;				// outliers
+};
+
+/**
+ * @brief  Compare times for qsort()
+ */
+static
+int cmp_ll(const void * a, const void * b) {
+	long long x = *(const long long *) a;
+	long long y = *(const long long *) b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief  Convert timeval to nanoseconds
+ *
+ * @param tv time to convert
+ *
+ * @return   nanoseconds
+ */
+static inline
+long long tv_ns(const struct timeval * tv) {
+	return tv->tv_sec * 1000000000LL + tv->tv_usec * 1000LL;
+}
+
+/**
+ * @brief  Run command once and record it
+ *
+ * @param t command to run
+ * @param attr attributes of the command
+ * @param record false for warmup runs
+ *
+ * @return   exit status, -1 if the command could not be run
+ */
+static
+int timing_run(struct timing_t * t, const struct spawn_attr_t * attr, bool record) {
+	struct rusage ru;
+	int64_t start;
+	int status;
+	pid_t pid;
+
+	// every run reads its input from the beginning
+	if (attr->fd_in >= 0)
+		lseek(attr->fd_in, 0, SEEK_SET);
+
+	start = stats_now();
+	if ((pid = spawn_command(t->argv, attr)) < 0)
+		return -1;
+	status = spawn_wait_rusage(pid, &ru);
+
+	if (! record || status < 0)
+		return status;
+
+	t->wall[t->runs++] = stats_now() - start;
+	t->user += tv_ns(&ru.ru_utime);
+	t->sys += tv_ns(&ru.ru_stime);
+	if (ru.ru_maxrss > t->maxrss)
+		t->maxrss = ru.ru_maxrss;
+	if (status != 0)
+		t->failed++;
+
+	return status;
+}
+
+/**
+ * @brief  Get value at a percentile of sorted samples
+ *
+ * @param sorted samples
+ * @param n number of samples
+ * @param p percentile, 0 to 100
+ *
+ * @return   value (nearest rank)
+ */
+static
+long long percentile(const long long * sorted, int n, double p) {
+	int rank = (int) ceil(p / 100 * n) - 1;
+
+	return sorted[rank < 0 ? 0 : (rank >= n ? n - 1 : rank)];
+}
+
+/**
+ * @brief  Compute summary of a command
+ *
+ * @param t command to use, wall is sorted in place
+ */
+static
+void timing_summarize(struct timing_t * t) {
+	double sum = 0, var = 0;
+	long long q1, q3, iqr;
+	int n = t->runs;
+
+	for (int i = 0; i < n; ++i)
+		sum += t->wall[i];
+	t->mean = sum / n;
+
+	for (int i = 0; i < n; ++i)
+		var += (t->wall[i] - t->mean) * (t->wall[i] - t->mean);
+	t->stddev = n > 1 ? sqrt(var / (n - 1)) : 0;
+
+	qsort(t->wall, n, sizeof(long long), cmp_ll);
+	t->min = t->wall[0];
+	t->max = t->wall[n - 1];
+	t->p50 = percentile(t->wall, n, 50);
+	t->p95 = percentile(t->wall, n, 95);
+	t->p99 = percentile(t->wall, n, 99);
+
+	// Tukey's fences
+	q1 = percentile(t->wall, n, 25);
+	q3 = percentile(t->wall, n, 75);
+	iqr = q3 - q1;
+	t->low = t->high = 0;
+	for (int i = 0; i < n; ++i) {
+		if (t->wall[i] < q1 - 1.5 * iqr)
+			t->low++;
+		else if (t->wall[i] > q3 + 1.5 * iqr)
+			t->high++;
+	}
+}
+
+/**
+ * @brief  Format command for humans
+ *
+ * @param argv command
+ * @param buf where to store result
+ * @param len size of buf
+ */
+static
+void format_command(char ** argv, char * buf, size_t len) {
+	size_t off = 0;
+
+	buf[0] = '\0';
+	for (; *argv && off < len; ++argv)
+		off += snprintf(buf + off, len - off, "%s%s", off ? " " : "", *argv);
+}
+
+/**
+ * @brief  Print JSON string
+ *
+ * @param str string to print
+ */
+static
+void print_json_string(const char * str) {
+	putchar('"');
+	for (; *str; ++str) {
+		if (*str == '"' || *str == '\\')
+			printf("\\%c", *str);
+		else if ((unsigned char) *str < 0x20)
+			printf("\\u%04x", *str);
+		else
+			putchar(*str);
+	}
+	putchar('"');
+}
+
+/**
+ * @brief  Print results for humans
+ *
+ * @param t measured commands
+ * @param n number of commands
+ * @param warmup number of warmup runs
+ */
+static
+void print_human(const struct timing_t * t, int n, int warmup) {
+	char cmd[2][128];
+	double ratio, err;
+
+	for (int i = 0; i < n; ++i) {
+		format_command(t[i].argv, cmd[0], sizeof(cmd[0]));
+		printf("%s\n", cmd[0]);
+		printf("  wall  %10.3f ms +- %.3f ms (%d runs, %d warmup)\n",
+				t[i].mean / 1e6, t[i].stddev / 1e6, t[i].runs, warmup);
+		printf("        min %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f ms\n",
+				t[i].min / 1e6, t[i].p50 / 1e6, t[i].p95 / 1e6, t[i].p99 / 1e6,
+				t[i].max / 1e6);
+		printf("  cpu   user %.3f ms  sys %.3f ms (mean)  maxrss %ld KiB\n",
+				t[i].user / 1e6 / t[i].runs, t[i].sys / 1e6 / t[i].runs, t[i].maxrss);
+		printf("  %d low and %d high outliers, %d failed\n",
+				t[i].low, t[i].high, t[i].failed);
+	}
+
+	// ratio of means, errors propagated from relative stddevs
+	format_command(t[0].argv, cmd[0], sizeof(cmd[0]));
+	for (int i = 1; i < n; ++i) {
+		format_command(t[i].argv, cmd[1], sizeof(cmd[1]));
+		ratio = t[i].mean / t[0].mean;
+		err = ratio * sqrt(pow(t[0].stddev / t[0].mean, 2) + pow(t[i].stddev / t[i].mean, 2));
+		if (ratio >= 1)
+			printf("'%s' is %.2f +- %.2f times faster than '%s'\n", cmd[0], ratio, err, cmd[1]);
+		else
+			printf("'%s' is %.2f +- %.2f times slower than '%s'\n", cmd[0],
+					1 / ratio, err / ratio / ratio, cmd[1]);
+	}
+
+	fflush(stdout);
+}
+
+/**
+ * @brief  Print results as JSON
+ *
+ * @param t measured commands
+ * @param n number of commands
+ * @param warmup number of warmup runs
+ */
+static
+void print_json(const struct timing_t * t, int n, int warmup) {
+	char cmd[256];
+
+	printf("{\"results\":[");
+	for (int i = 0; i < n; ++i) {
+		format_command(t[i].argv, cmd, sizeof(cmd));
+		printf("%s{\"command\":", i ? "," : "");
+		print_json_string(cmd);
+		printf(",\"runs\":%d,\"warmup\":%d,\"mean_ms\":%.6f,\"stddev_ms\":%.6f,"
+				"\"min_ms\":%.6f,\"p50_ms\":%.6f,\"p95_ms\":%.6f,\"p99_ms\":%.6f,"
+				"\"max_ms\":%.6f,\"user_ms\":%.6f,\"sys_ms\":%.6f,\"maxrss_kb\":%ld,"
+				"\"outliers_low\":%d,\"outliers_high\":%d,\"failed\":%d}",
+				t[i].runs, warmup, t[i].mean / 1e6, t[i].stddev / 1e6,
+				t[i].min / 1e6, t[i].p50 / 1e6, t[i].p95 / 1e6, t[i].p99 / 1e6,
+				t[i].max / 1e6, t[i].user / 1e6 / t[i].runs, t[i].sys / 1e6 / t[i].runs,
+				t[i].maxrss, t[i].low, t[i].high, t[i].failed);
+	}
+	printf("]}\n");
+	fflush(stdout);
+}
+
+/**
+ * @brief  Parse positive number option
+ *
+ * @param str string to parse
+ * @param val where to store value
+ * @param min minimum allowed value
+ *
+ * @return   true on success
+ */
+static
+bool parse_count(const char * str, int * val, int min) {
+	char * end;
+	long l;
+
+	if (! str)
+		return false;
+
+	l = strtol(str, &end, 10);
+	if (*end || l < min || l > 1000000)
+		return false;
+
+	*val = (int) l;
+
+	return true;
+}
+
+/**
+ * @brief  Time command(s) run through the spawn path of the shell
+ *
+ * Compared commands are run interleaved, slow drift of the machine does
+ * not favour any of them. Output goes to /dev/null unless redirected.
+ *
+ * @param argv NULL terminated vector, argv[0] is the "bench" prefix
+ * @param attr attributes of the command, redirections included
+ *
+ * @return   0 if all runs succeeded, 1 if some failed, -1 on error
+ */
+int timing_command(char ** argv, const struct spawn_attr_t * attr) {
+	struct timing_t t[TIMING_MAX_CMDS];
+	struct spawn_attr_t child = *attr;
+	int runs = TIMING_RUNS, warmup = TIMING_WARMUP;
+	bool json = false;
+	int ret = 0;
+	int n = 0, i, r, status;
+	int devnull = -1;
+
+	for (++argv; *argv && (*argv)[0] == '-'; ++argv) {
+		if (! strcmp(*argv, "-n") && parse_count(argv[1], &runs, 1))
+			++argv;
+		else if (! strcmp(*argv, "-w") && parse_count(argv[1], &warmup, 0))
+			++argv;
+		else if (! strcmp(*argv, "-j"))
+			json = true;
+		else
+			break;
+	}
+
+	if (! *argv || (*argv)[0] == '-') {
+		write(2, ERR_TIMING_USAGE, strlen(ERR_TIMING_USAGE));
+		return -1;
+	}
+
+	if (attr->background) {
+		write(2, ERR_TIMING_BACKGROUND, strlen(ERR_TIMING_BACKGROUND));
+		return -1;
+	}
+
+	// split at TIMING_SEP, argv is ours to modify
+	memset(t, 0, sizeof(t));
+	for (t[n++].argv = argv; *argv; ++argv) {
+		if (strcmp(*argv, TIMING_SEP))
+			continue;
+
+		*argv = NULL;
+		if (! argv[1] || n == TIMING_MAX_CMDS) {
+			write(2, ERR_TIMING_USAGE, strlen(ERR_TIMING_USAGE));
+			return -1;
+		}
+		t[n++].argv = argv + 1;
+	}
+
+	for (i = 0; i < n; ++i) {
+		if (! (t[i].wall = (long long *) malloc(runs * sizeof(long long)))) {
+			ret = -1;
+			goto out;
+		}
+	}
+
+	if (child.fd_out == SPAWN_FD_INHERIT
+			&& (devnull = open("/dev/null", O_WRONLY | O_CLOEXEC)) >= 0)
+		child.fd_out = devnull;
+
+	for (r = -warmup; r < runs; ++r) {
+		for (i = 0; i < n; ++i) {
+			if ((status = timing_run(&t[i], &child, r >= 0)) < 0) {
+				write(2, ERR_TIMING_SPAWN, strlen(ERR_TIMING_SPAWN));
+				ret = -1;
+				goto out;
+			}
+
+			if (status == 128 + SIGINT) { // ^C stops the whole benchmark
+				write(2, ERR_TIMING_INTERRUPT, strlen(ERR_TIMING_INTERRUPT));
+				ret = -1;
+				goto out;
+			}
+		}
+	}
+
+	for (i = 0; i < n; ++i) {
+		timing_summarize(&t[i]);
+		if (t[i].failed)
+			ret = 1;
+	}
+
+	if (json)
+		print_json(t, n, warmup);
+	else
+		print_human(t, n, warmup);
+
+out:
+	if (devnull >= 0)
+		close(devnull);
+
+	for (i = 0; i < n; ++i)
+		free(t[i].wall);
+
+	return ret;
+}
+
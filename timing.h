@@ -0,0 +1,44 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/19/2026 05:12:44 AM
+ *
+ ***********************************************************************
+ */
+
+#ifndef TIMING_H_
+#define TIMING_H_
+
+#include "spawn.h"
+
+/*
+ * Builtin to time commands, e.g. bench -n 50 -w 5 cmd args :: cmd2 args
+ */
+#define TIMING_CMD			"bench"
+
+/*
+ * Separates compared commands
+ */
+#define TIMING_SEP			"::"
+
+/*
+ * Default number of measured and warmup runs
+ */
+#ifndef TIMING_RUNS
+# define TIMING_RUNS			10
+#endif // TIMING_RUNS
+
+#ifndef TIMING_WARMUP
+# define TIMING_WARMUP		1
+#endif // TIMING_WARMUP
+
+/*
+ * Maximum number of compared commands
+ */
+#define TIMING_MAX_CMDS		8
+
+int timing_command(char ** argv, const struct spawn_attr_t * attr);
+
+#endif // TIMING_H_
+
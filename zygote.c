@@ -0,0 +1,344 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 09:04:52 PM
+ *
+ ***********************************************************************
+ */
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <linux/sched.h>
+#include <pthread.h>
+#include <errno.h>
+
+#include "zygote.h"
+#include "fdpass.h"
+
+/*
+ * The fork server is a tiny single threaded process forked at shell init.
+ * It receives argv, environment, working directory and redirections over
+ * a Unix socket and clones the requested child with CLONE_PARENT, so the
+ * child is a child of the shell (SIGCHLD and waitpid() work as usual)
+ * while the shell never has to duplicate its own, possibly large and
+ * multithreaded, state.
+ */
+
+/*
+ * Redirection descriptor was passed using SCM_RIGHTS
+ */
+#define ZYGOTE_FD_PASSED		0
+
+/**
+ * @brief  Spawn request header, followed by length bytes of NUL
+ *         terminated argv and environment strings and working directory
+ */
+struct zygote_req_t {
+	uint32_t argc;
+	uint32_t envc;
+	uint32_t length;
+	int32_t fd_in;
+	int32_t fd_out;
+	int32_t fd_err;
+	uint32_t cwd;			// working directory follows environment
+	uint32_t background;
+	struct place_t place;
+	struct prio_t prio;
+};
+
+/**
+ * @brief  Spawn reply, pidfd of the child is passed using SCM_RIGHTS
+ */
+struct zygote_rep_t {
+	int32_t pid;
+	int32_t error;
+};
+
+extern char ** environ;
+
+/*
+ * Shell side of the connection, -1 if not running
+ */
+static int zygote_sock = -1;
+static pid_t zygote_pid = -1;
+static pthread_mutex_t zygote_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief  Clone a child of our parent, i.e. of the shell
+ *
+ * @param pidfd where to store pidfd of the child
+ *
+ * @return   like fork()
+ */
+static
+pid_t clone_parent(int * pidfd) {
+	struct clone_args args;
+
+	memset(&args, 0, sizeof(args));
+	args.flags = CLONE_PARENT | CLONE_PIDFD;
+	args.pidfd = (uint64_t) (uintptr_t) pidfd;
+	// exit signal is inherited from the fork server, i.e. SIGCHLD
+	args.exit_signal = 0;
+
+	return syscall(SYS_clone3, &args, sizeof(args));
+}
+
+/**
+ * @brief  Serve one spawn request, called in the fork server only
+ *
+ * @param sock socket to use
+ *
+ * @return   false on end of file
+ */
+static
+bool zygote_serve(int sock) {
+	struct zygote_req_t req;
+	struct zygote_rep_t rep;
+	struct spawn_attr_t attr;
+	char * data = NULL;
+	char ** vec = NULL;
+	char * str;
+	int fds[FDPASS_MAX];
+	int nfds = FDPASS_MAX;
+	int pidfd = -1;
+	int passed = 0;
+	uint32_t i;
+
+	if (! fdpass_recv(sock, &req, sizeof(req), fds, &nfds))
+		return false;
+
+	data = (char *) malloc(req.length + 1);
+	vec = (char **) malloc((req.argc + req.envc + 2) * sizeof(char *));
+	if (! data || ! vec || ! fdpass_recv(sock, data, req.length, NULL, &passed)) {
+		free(data); free(vec);
+		while (nfds-- > 0)
+			close(fds[nfds]);
+		return false;
+	}
+	data[req.length] = '\0';
+
+	// unpack argv followed by environment
+	for (i = 0, str = data; i < req.argc; ++i, str += strlen(str) + 1)
+		vec[i] = str;
+	vec[req.argc] = (char *) 0;
+
+	for (i = 0; i < req.envc; ++i, str += strlen(str) + 1)
+		vec[req.argc + 1 + i] = str;
+	vec[req.argc + 1 + req.envc] = (char *) 0;
+
+	spawn_attr_init(&attr);
+	if (req.cwd)
+		attr.cwd = str;
+	attr.background = req.background;
+	attr.place = req.place;
+	attr.prio = req.prio;
+	attr.fd_in = req.fd_in;
+	attr.fd_out = req.fd_out;
+	attr.fd_err = req.fd_err;
+	passed = 0;
+	if (attr.fd_in == ZYGOTE_FD_PASSED)
+		attr.fd_in = passed < nfds ? fds[passed++] : SPAWN_FD_INHERIT;
+	if (attr.fd_out == ZYGOTE_FD_PASSED)
+		attr.fd_out = passed < nfds ? fds[passed++] : SPAWN_FD_INHERIT;
+	if (attr.fd_err == ZYGOTE_FD_PASSED)
+		attr.fd_err = passed < nfds ? fds[passed++] : SPAWN_FD_INHERIT;
+
+	rep.pid = clone_parent(&pidfd);
+	rep.error = rep.pid < 0 ? errno : 0;
+
+	if (rep.pid == 0) { // child
+		if (! spawn_child_setup(&attr))
+			_exit(EXIT_FAILURE);
+
+		// PATH of the shell is searched as in spawn_vfork()
+		execvpe(vec[0], vec, &vec[req.argc + 1]);
+		perror(vec[0]);
+		_exit(127);
+	}
+
+	fdpass_send(sock, &rep, sizeof(rep), &pidfd, pidfd >= 0 ? 1 : 0);
+
+	if (pidfd >= 0)
+		close(pidfd);
+	while (nfds-- > 0)
+		close(fds[nfds]);
+	free(data);
+	free(vec);
+
+	return true;
+}
+
+/**
+ * @brief  Start fork server, has to be called while single threaded
+ *
+ * @return   true on success
+ */
+bool zygote_start() {
+	struct sigaction sigact;
+	int sv[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) {
+		perror("socketpair");
+		return false;
+	}
+
+	zygote_pid = fork();
+	if (zygote_pid < 0) {
+		perror("fork failed");
+		close(sv[0]); close(sv[1]);
+		return false;
+	} else if (zygote_pid == 0) { // fork server
+		close(sv[0]);
+
+		sigemptyset(&sigact.sa_mask);
+		sigact.sa_flags = 0;
+		sigact.sa_handler = SIG_DFL;
+		sigaction(SIGCHLD, &sigact, NULL);
+
+		while (zygote_serve(sv[1]))
+			;
+
+		_exit(EXIT_SUCCESS);
+	}
+
+	close(sv[1]);
+	zygote_sock = sv[0];
+
+	return true;
+}
+
+/**
+ * @brief  Is fork server available?
+ *
+ * @return   true if running
+ */
+bool zygote_running() {
+	return zygote_sock >= 0;
+}
+
+/**
+ * @brief  Spawn a command using the fork server
+ *
+ * @param argv NULL terminated argument vector
+ * @param attr attributes of the new process, attr->pidlist is not used
+ * @param pidfd where to store pidfd of the child, NULL to close it
+ *
+ * @return   PID of the child or -1 on failure, zygote_running() is false
+ *           if the fork server is gone or unable to spawn anything
+ */
+pid_t zygote_spawn(char ** argv, const struct spawn_attr_t * attr, int * pidfd) {
+	struct zygote_req_t req;
+	struct zygote_rep_t rep;
+	char ** envp = attr->envp ? attr->envp : environ;
+	char * data, * str;
+	char ** it;
+	int fds[FDPASS_MAX];
+	int nfds = 0;
+	int fd = -1;
+	int nrecv = 1;
+	bool unusable;
+	bool ok;
+
+	memset(&req, 0, sizeof(req));
+	for (it = argv; *it; ++it, ++req.argc)
+		req.length += strlen(*it) + 1;
+	for (it = envp; it && *it; ++it, ++req.envc)
+		req.length += strlen(*it) + 1;
+	if (attr->cwd) {
+		req.cwd = 1;
+		req.length += strlen(attr->cwd) + 1;
+	}
+
+	data = (char *) malloc(req.length);
+	if (! data)
+		return -1;
+
+	for (it = argv, str = data; *it; ++it)
+		str = stpcpy(str, *it) + 1;
+	for (it = envp; it && *it; ++it)
+		str = stpcpy(str, *it) + 1;
+	if (attr->cwd)
+		strcpy(str, attr->cwd);
+
+	req.background = attr->background;
+	req.place = attr->place;
+	req.prio = attr->prio;
+	req.fd_in = attr->fd_in;
+	req.fd_out = attr->fd_out;
+	req.fd_err = attr->fd_err;
+	if (attr->fd_in >= 0) {
+		req.fd_in = ZYGOTE_FD_PASSED;
+		fds[nfds++] = attr->fd_in;
+	}
+	if (attr->fd_out >= 0) {
+		req.fd_out = ZYGOTE_FD_PASSED;
+		fds[nfds++] = attr->fd_out;
+	}
+	if (attr->fd_err >= 0) {
+		req.fd_err = ZYGOTE_FD_PASSED;
+		fds[nfds++] = attr->fd_err;
+	}
+
+	pthread_mutex_lock(&zygote_mutex);
+	ok = zygote_sock >= 0
+		&& fdpass_send(zygote_sock, &req, sizeof(req), fds, nfds)
+		&& fdpass_send(zygote_sock, data, req.length, NULL, 0)
+		&& fdpass_recv(zygote_sock, &rep, sizeof(rep), &fd, &nrecv);
+	// clone3() is not allowed there (old kernel, seccomp), no command would run
+	unusable = ok && rep.pid < 0 && (rep.error == ENOSYS || rep.error == EPERM);
+	if ((! ok || unusable) && zygote_sock >= 0) { // fork server is gone
+		close(zygote_sock);
+		zygote_sock = -1;
+	}
+	pthread_mutex_unlock(&zygote_mutex);
+
+	free(data);
+
+	if (nrecv == 0)
+		fd = -1;
+
+	if (unusable)
+		errno = rep.error;
+
+	if (! ok || unusable) {
+		perror("fork server");
+		return -1;
+	}
+
+	if (rep.pid < 0) {
+		errno = rep.error;
+		perror("fork failed");
+	}
+
+	if (pidfd)
+		*pidfd = fd;
+	else if (fd >= 0)
+		close(fd);
+
+	return rep.pid;
+}
+
+/**
+ * @brief  Stop fork server
+ */
+void zygote_stop() {
+	if (zygote_sock >= 0) {
+		close(zygote_sock);
+		zygote_sock = -1;
+	}
+
+	if (zygote_pid > 0) {
+		waitpid(zygote_pid, NULL, 0);
+		zygote_pid = -1;
+	}
+}
+
@@ -0,0 +1,24 @@
+/*
+ ***********************************************************************
+ *
+ *        @version  1.0
+ *        @date     10/18/2026 09:04:37 PM
+ *
+ ***********************************************************************
+ */
+
+#ifndef ZYGOTE_H_
+#define ZYGOTE_H_
+
+#include <sys/types.h>
+#include <stdbool.h>
+
+#include "spawn.h"
+
+bool zygote_start();
+bool zygote_running();
+pid_t zygote_spawn(char ** argv, const struct spawn_attr_t * attr, int * pidfd);
+void zygote_stop();
+
+#endif // ZYGOTE_H_
+